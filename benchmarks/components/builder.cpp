@@ -0,0 +1,67 @@
+#include "components/builder.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "drawtypes/label.hpp"
+#include "drawtypes/progressbar.hpp"
+
+using namespace polybar;
+using namespace drawtypes;
+
+static bar_settings make_settings() {
+  bar_settings settings{};
+  settings.foreground = rgba("#c5c8c6");
+  settings.background = rgba("#282a2e");
+  settings.spacing = ZERO_SPACE;
+  return settings;
+}
+
+static void BM_BuildLabel(benchmark::State& state) {
+  bar_settings settings = make_settings();
+  builder b{settings};
+  auto label = std::make_shared<drawtypes::label>("CPU 12%", rgba("#fba922"), rgba("#3f3f3f"), rgba("#ff0000"));
+  label->m_padding = {spacing_val{spacing_type::SPACE, 1}, spacing_val{spacing_type::SPACE, 1}};
+
+  for (auto _ : state) {
+    b.node(label);
+    auto output = b.flush();
+    benchmark::DoNotOptimize(output);
+  }
+}
+BENCHMARK(BM_BuildLabel);
+
+static void BM_BuildActionLabels(benchmark::State& state) {
+  bar_settings settings = make_settings();
+  builder b{settings};
+  auto label = std::make_shared<drawtypes::label>("workspace", rgba("#fba922"));
+
+  for (auto _ : state) {
+    for (int i = 0; i < 10; i++) {
+      b.action(mousebtn::LEFT, "#i3.focus." + to_string(i), label);
+    }
+    auto output = b.flush();
+    benchmark::DoNotOptimize(output);
+  }
+}
+BENCHMARK(BM_BuildActionLabels);
+
+static void BM_BuildProgressbar(benchmark::State& state) {
+  bar_settings settings = make_settings();
+  builder b{settings};
+
+  progressbar bar{settings, static_cast<int>(state.range(0)), "<fill><indicator><empty>"};
+  bar.set_fill(std::make_shared<drawtypes::label>("─", rgba("#55aa55")));
+  bar.set_indicator(std::make_shared<drawtypes::label>("|", rgba("#ffffff")));
+  bar.set_empty(std::make_shared<drawtypes::label>("─", rgba("#555555")));
+  bar.set_gradient(true);
+  bar.set_colors({rgba("#55aa55"), rgba("#557755"), rgba("#f5a70a"), rgba("#ff5555")});
+
+  float percentage = 0;
+  for (auto _ : state) {
+    b.node(bar.output(percentage));
+    auto output = b.flush();
+    benchmark::DoNotOptimize(output);
+    percentage = percentage >= 100 ? 0 : percentage + 7;
+  }
+}
+BENCHMARK(BM_BuildProgressbar)->Arg(10)->Arg(40);
@@ -0,0 +1,40 @@
+#include "drawtypes/label.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace polybar;
+using namespace drawtypes;
+
+static void BM_ReplaceToken(benchmark::State& state) {
+  label l{"%percentage%% %time% %consumption%W", 0};
+
+  for (auto _ : state) {
+    l.reset_tokens();
+    l.replace_token("%percentage%", "98");
+    l.replace_token("%time%", "01:23:45");
+    l.replace_token("%consumption%", "12.5");
+    benchmark::DoNotOptimize(l.get());
+  }
+}
+BENCHMARK(BM_ReplaceToken);
+
+/**
+ * Tokens with min/max lengths, which go through the padding and truncation
+ * paths.
+ */
+static void BM_ReplaceTokenFormatted(benchmark::State& state) {
+  vector<token> tokens{
+      {"%title%", 10, 30, "...", false, false},
+      {"%percentage%", 3, 0, "", true, false},
+  };
+  label l{"%title% %percentage%%", rgba{}, rgba{}, rgba{}, rgba{}, 0, {ZERO_SPACE, ZERO_SPACE}, {ZERO_SPACE, ZERO_SPACE},
+      0, 0_z, alignment::LEFT, true, std::move(tokens)};
+
+  for (auto _ : state) {
+    l.reset_tokens();
+    l.replace_token("%title%", "polybar/src/components/controller.cpp - vim");
+    l.replace_token("%percentage%", "7");
+    benchmark::DoNotOptimize(l.get());
+  }
+}
+BENCHMARK(BM_ReplaceTokenFormatted);
@@ -0,0 +1,40 @@
+#include "ipc/decoder.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "components/logger.hpp"
+#include "ipc/encoder.hpp"
+#include "ipc/msg.hpp"
+
+using namespace polybar;
+using namespace ipc;
+
+static logger null_logger(loglevel::NONE);
+
+/**
+ * Decodes a buffer holding many messages, fed to the decoder in chunks of
+ * the given size (like reads from the socket).
+ */
+static void BM_Decode(benchmark::State& state) {
+  const size_t chunk = state.range(0);
+  const auto msg = encode(to_integral(v0::ipc_type::ACTION), "#pulseaudio.inc");
+
+  vector<uint8_t> stream;
+  for (int i = 0; i < 100; i++) {
+    stream.insert(stream.end(), msg.begin(), msg.end());
+  }
+
+  size_t received = 0;
+  for (auto _ : state) {
+    // A decoder only handles a single connection, so every iteration uses a new one
+    decoder dec{null_logger, [&](uint8_t, type_t, const vector<uint8_t>& data) { received += data.size(); }};
+
+    for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+      dec.on_read(stream.data() + pos, std::min(chunk, stream.size() - pos));
+    }
+  }
+
+  benchmark::DoNotOptimize(received);
+  state.SetBytesProcessed(state.iterations() * stream.size());
+}
+BENCHMARK(BM_Decode)->Arg(7)->Arg(64)->Arg(65536);
@@ -0,0 +1,69 @@
+#include "tags/action_context.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace polybar;
+using namespace tags;
+
+static constexpr int BAR_WIDTH = 1920;
+
+/**
+ * Opens `n` evenly spaced actions per alignment, each nested inside a
+ * scroll action covering the whole alignment block.
+ */
+static void fill_context(action_context& ctxt, int n) {
+  ctxt.reset();
+
+  for (auto align : {alignment::LEFT, alignment::CENTER, alignment::RIGHT}) {
+    double width = BAR_WIDTH / 3.0;
+    ctxt.set_alignment_start(align, width * (static_cast<int>(align) - 1));
+    ctxt.action_open(mousebtn::SCROLL_UP, "#module.inc", align, 0);
+
+    for (int i = 0; i < n; i++) {
+      double x = width * i / n;
+      ctxt.action_open(mousebtn::LEFT, "#module.click." + to_string(i), align, x);
+      ctxt.action_close(mousebtn::LEFT, align, x + width / n - 1);
+    }
+
+    ctxt.action_close(mousebtn::SCROLL_UP, align, width);
+  }
+}
+
+static void BM_HasAction(benchmark::State& state) {
+  action_context ctxt;
+  fill_context(ctxt, state.range(0));
+
+  int x = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ctxt.has_action(mousebtn::LEFT, x));
+    x = (x + 37) % BAR_WIDTH;
+  }
+}
+BENCHMARK(BM_HasAction)->Arg(4)->Arg(32)->Arg(256);
+
+static void BM_GetActions(benchmark::State& state) {
+  action_context ctxt;
+  fill_context(ctxt, state.range(0));
+
+  int x = 0;
+  for (auto _ : state) {
+    auto actions = ctxt.get_actions(x);
+    benchmark::DoNotOptimize(actions);
+    x = (x + 37) % BAR_WIDTH;
+  }
+}
+BENCHMARK(BM_GetActions)->Arg(4)->Arg(32)->Arg(256);
+
+/**
+ * A full frame: the actions are recreated and then hit tested once, like a
+ * redraw followed by a single pointer motion.
+ */
+static void BM_FillAndHitTest(benchmark::State& state) {
+  action_context ctxt;
+
+  for (auto _ : state) {
+    fill_context(ctxt, state.range(0));
+    benchmark::DoNotOptimize(ctxt.has_action(mousebtn::LEFT, BAR_WIDTH / 2));
+  }
+}
+BENCHMARK(BM_FillAndHitTest)->Arg(4)->Arg(32)->Arg(256);
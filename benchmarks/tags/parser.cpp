@@ -0,0 +1,51 @@
+#include "tags/parser.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace polybar;
+using namespace tags;
+
+/**
+ * Roughly what a bar with workspaces, a window title, a clock and a few
+ * system modules produces per update.
+ */
+static const string BAR_CONTENTS =
+    "%{l}%{A1:#i3.focus.1:}%{B#3f3f3f}%{u#fba922}%{+u} 1 %{-u}%{B-}%{A}"
+    "%{A1:#i3.focus.2:}%{F#555} 2 %{F-}%{A}%{A1:#i3.focus.3:}%{F#555} 3 %{F-}%{A}"
+    "%{O10}%{T2}~/src/polybar - vim%{T-}"
+    "%{c}%{A1:#date.toggle:}%{F#0a6cf5}%{F-} 2024-08-17 12:34%{A}"
+    "%{r}%{A4:#pulseaudio.inc:}%{A5:#pulseaudio.dec:}%{A3:#pulseaudio.toggle:}%{F#fba922}VOL%{F-} 42%%{A}%{A}%{A}"
+    "%{O6}%{F#fba922}CPU%{F-} 12% %{F#55aa55}▁▂▃▅%{F-}"
+    "%{O6}%{F#fba922}RAM%{F-} 41%%{O6}%{+o}%{o#f00}wlan0 192.168.0.2%{-o}"
+    "%{O6}%{R} BAT 98% %{R}%{PR}";
+
+static void BM_ParseBar(benchmark::State& state) {
+  string input;
+  for (int i = 0; i < state.range(0); i++) {
+    input += BAR_CONTENTS;
+  }
+
+  parser p;
+  for (auto _ : state) {
+    p.set(string{input});
+    auto result = p.parse();
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseBar)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_ParsePlainText(benchmark::State& state) {
+  string input(state.range(0), 'a');
+
+  parser p;
+  for (auto _ : state) {
+    p.set(string{input});
+    auto result = p.parse();
+    benchmark::DoNotOptimize(result);
+  }
+
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParsePlainText)->Arg(64)->Arg(1024);
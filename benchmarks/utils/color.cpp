@@ -0,0 +1,25 @@
+#include "utils/color.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace polybar;
+
+static void BM_ParseHex(benchmark::State& state, const char* hex) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rgba{hex});
+  }
+}
+BENCHMARK_CAPTURE(BM_ParseHex, rgb, "#f0a");
+BENCHMARK_CAPTURE(BM_ParseHex, rrggbb, "#ff00aa");
+BENCHMARK_CAPTURE(BM_ParseHex, aarrggbb, "#80ff00aa");
+BENCHMARK_CAPTURE(BM_ParseHex, alpha_only, "#80");
+BENCHMARK_CAPTURE(BM_ParseHex, invalid, "#xyz");
+
+static void BM_ToString(benchmark::State& state) {
+  rgba color{"#80ff00aa"};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(static_cast<string>(color));
+  }
+}
+BENCHMARK(BM_ToString);
@@ -0,0 +1,50 @@
+#include "utils/process.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+using namespace polybar;
+
+/**
+ * Touches `mib` MiB of memory so that the page tables of the process grow
+ * the way they do with loaded fonts and a large bar
+ */
+static vector<char> resident(size_t mib) {
+  vector<char> memory(mib << 20);
+  memset(memory.data(), 1, memory.size());
+  return memory;
+}
+
+/**
+ * Latency of starting a shell command until it exited
+ */
+static void BM_SpawnSh(benchmark::State& state) {
+  auto memory = resident(state.range(0));
+
+  for (auto _ : state) {
+    pid_t pid = process_util::spawn_sh(":");
+    waitpid(pid, nullptr, 0);
+  }
+}
+BENCHMARK(BM_SpawnSh)->ArgName("rss_mib")->Arg(0)->Arg(256)->Arg(1024)->UseRealTime();
+
+/**
+ * Same as above, but with fork and exec for comparison
+ */
+static void BM_ForkExec(benchmark::State& state) {
+  auto memory = resident(state.range(0));
+
+  for (auto _ : state) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execl("/bin/sh", "/bin/sh", "-c", ":", nullptr);
+      _exit(127);
+    }
+    waitpid(pid, nullptr, 0);
+  }
+}
+BENCHMARK(BM_ForkExec)->ArgName("rss_mib")->Arg(0)->Arg(256)->Arg(1024)->UseRealTime();
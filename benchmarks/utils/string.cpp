@@ -0,0 +1,53 @@
+#include "utils/string.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace polybar;
+
+static const string ASCII = "The quick brown fox jumps over the lazy dog";
+static const string UTF8 = "Ŧħə qüíčķ ƀŗøŵñ ƒøχ ĵüɱƥš øvəř ŧħə łäžÿ đøğ 🦊";
+
+static void BM_ReplaceAll(benchmark::State& state) {
+  string haystack;
+  for (int i = 0; i < 10; i++) {
+    haystack += "%{F#fff}" + ASCII + "%{F-}";
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string_util::replace_all(haystack, "%{F-}", "%{F#000}"));
+  }
+}
+BENCHMARK(BM_ReplaceAll);
+
+static void BM_Utf8ToUcs4(benchmark::State& state) {
+  const string& input = state.range(0) ? UTF8 : ASCII;
+
+  for (auto _ : state) {
+    string_util::unicode_charlist list;
+    bool result = string_util::utf8_to_ucs4(input, list);
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(list);
+  }
+
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Utf8ToUcs4)->ArgName("utf8")->Arg(0)->Arg(1);
+
+static void BM_Utf8Truncate(benchmark::State& state) {
+  const string& input = state.range(0) ? UTF8 : ASCII;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string_util::utf8_truncate(string{input}, 20));
+  }
+}
+BENCHMARK(BM_Utf8Truncate)->ArgName("utf8")->Arg(0)->Arg(1);
+
+static void BM_FloatingPoint(benchmark::State& state) {
+  double value = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string_util::floating_point(value, 2, true));
+    value += 0.37;
+  }
+}
+BENCHMARK(BM_FloatingPoint);
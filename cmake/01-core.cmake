@@ -14,6 +14,7 @@ endif()
 option(BUILD_POLYBAR "Build the main polybar executable" ${DEFAULT_ON})
 option(BUILD_POLYBAR_MSG "Build polybar-msg" ${DEFAULT_ON})
 option(BUILD_TESTS "Build testsuite" OFF)
+option(BUILD_BENCHMARKS "Build benchmarks" OFF)
 option(BUILD_DOC "Build documentation" ${DEFAULT_ON})
 option(BUILD_CONFIG "Generate default configuration" ${DEFAULT_ON})
 option(BUILD_SHELL "Generate shell completion files" ${DEFAULT_ON})
@@ -22,13 +23,13 @@ include(CMakeDependentOption)
 CMAKE_DEPENDENT_OPTION(BUILD_DOC_HTML "Build HTML documentation" ON "BUILD_DOC" OFF)
 CMAKE_DEPENDENT_OPTION(BUILD_DOC_MAN "Build manpages" ON "BUILD_DOC" OFF)
 
-if (BUILD_POLYBAR OR BUILD_TESTS OR BUILD_POLYBAR_MSG)
+if (BUILD_POLYBAR OR BUILD_TESTS OR BUILD_BENCHMARKS OR BUILD_POLYBAR_MSG)
   set(BUILD_LIBPOLY ON)
 else()
   set(BUILD_LIBPOLY OFF)
 endif()
 
-if (BUILD_POLYBAR OR BUILD_POLYBAR_MSG OR BUILD_TESTS)
+if (BUILD_POLYBAR OR BUILD_POLYBAR_MSG OR BUILD_TESTS OR BUILD_BENCHMARKS)
   set(HAS_CXX_COMPILATION ON)
 else()
   set(HAS_CXX_COMPILATION OFF)
@@ -2,20 +2,24 @@
 
 #include <arpa/inet.h>
 #include <ifaddrs.h>
+#include <poll.h>
 
 #include <chrono>
 #include <cstdlib>
+#include <functional>
 
 #include "common.hpp"
 #include "components/logger.hpp"
 #include "errors.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
 #include "utils/math.hpp"
 
 #if WITH_LIBNL
 #include <net/if.h>
 
 struct nl_msg;
+struct nl_sock;
 struct nlattr;
 #else
 #include <iwlib.h>
@@ -30,9 +34,9 @@ struct nlattr;
 #endif
 #endif
 
-POLYBAR_NS
+struct nlmsghdr;
 
-class file_descriptor;
+POLYBAR_NS
 
 namespace net {
   DEFINE_ERROR(network_error);
@@ -57,7 +61,7 @@ namespace net {
     }
   };
 
-  using bytes_t = unsigned int;
+  using bytes_t = unsigned long long;
 
   struct link_activity {
     bytes_t transmitted{0};
@@ -73,6 +77,137 @@ namespace net {
     link_activity current{};
   };
 
+  // }}}
+  // class : connectivity_check {{{
+
+  /**
+   * @brief Checks whether CONNECTION_TEST_IP can be reached, without blocking
+   *
+   * Works like `ping -c 2 -W 2`: two ICMP echo requests are sent one second
+   * apart through an unprivileged ICMP datagram socket and the check fails if
+   * no reply arrives within two seconds of the last one. If this user is not
+   * allowed to open such sockets (see net.ipv4.ping_group_range), a DNS query
+   * is sent over UDP instead.
+   *
+   * Any reply to the UDP query counts, as does an ICMP error for it.
+   *
+   * Nothing is read or sent on its own, process() has to be called whenever
+   * fd() becomes readable and once deadline() is reached.
+   */
+  class connectivity_check {
+   public:
+    using clock = std::chrono::steady_clock;
+
+    explicit connectivity_check(string interface);
+
+    /**
+     * Always sends the UDP query, to `port` on `host`, with `interval` between
+     * the probes instead of one second
+     */
+    connectivity_check(string interface, string host, uint16_t port, std::chrono::milliseconds interval);
+
+    /**
+     * Starts a new check unless one is still running
+     */
+    void start();
+
+    /**
+     * Reads replies and sends the second probe when it is due
+     *
+     * @returns true if the running check finished
+     */
+    bool process();
+
+    bool running() const;
+
+    /**
+     * @returns Whether a reply arrived during the last finished check
+     */
+    bool reachable() const;
+
+    /**
+     * @returns The socket replies arrive on or -1 if there is none
+     */
+    int fd() const;
+
+    /**
+     * @returns The latest time process() has to be called at
+     */
+    clock::time_point deadline() const;
+
+   protected:
+    bool open();
+    void send_probe();
+    bool receive_reply();
+
+   private:
+    static constexpr int PROBES{2};
+
+    string m_interface;
+    string m_host{CONNECTION_TEST_IP};
+    uint16_t m_port{0};
+    std::chrono::milliseconds m_interval{1000};
+
+    file_descriptor m_fd{-1};
+    bool m_icmp{true};
+
+    bool m_running{false};
+    bool m_reachable{false};
+    int m_sent{0};
+    uint16_t m_sequence{0};
+    uint16_t m_first_sequence{0};
+    clock::time_point m_next_probe;
+    clock::time_point m_timeout;
+  };
+
+  // }}}
+  // rtnetlink messages {{{
+
+  /**
+   * Parsing of the rtnetlink messages the network adapter receives, separate
+   * from the sockets so that it works on any buffer
+   */
+  namespace rtnl {
+    using callback_t = std::function<void(const struct nlmsghdr*)>;
+
+    /**
+     * Walks the link and address notifications in `data`
+     *
+     * `ifindex` follows `interface` if it was recreated with a different
+     * index. The flags are only ever set, never cleared.
+     *
+     * @returns true if any of the notifications concern the interface
+     */
+    bool parse_events(const void* data, size_t size, const string& interface, unsigned int& ifindex,
+        bool& link_changed, bool& addresses_changed);
+
+    /**
+     * Calls `callback` for every message in `data` that belongs to the
+     * response to request `sequence`
+     *
+     * @returns 0 if the response is complete, an errno value if the request
+     *          failed or -1 if more messages follow
+     */
+    int parse_response(const void* data, size_t size, uint32_t sequence, const callback_t& callback);
+
+    /**
+     * Adds the byte counters of a RTM_NEWSTATS message to `activity`
+     */
+    void parse_stats(const struct nlmsghdr* msg, link_activity& activity);
+
+    /**
+     * Reads the operational state and hardware address of a RTM_NEWLINK message
+     */
+    void parse_link(const struct nlmsghdr* msg, unsigned char& operstate, string& mac);
+
+    /**
+     * Reads the address of a RTM_NEWADDR message if it belongs to `ifindex`
+     *
+     * Link-local, site-local and unique local ipv6 addresses are skipped.
+     */
+    void parse_address(const struct nlmsghdr* msg, unsigned int ifindex, string& ip, string& ip6);
+  }  // namespace rtnl
+
   // }}}
   // class : network {{{
 
@@ -83,7 +218,21 @@ namespace net {
 
     virtual bool query(bool accumulate = false);
     virtual bool connected() const = 0;
-    virtual bool ping() const;
+
+    /**
+     * Reads the pending notifications and responses, the changes are picked
+     * up by the next query()
+     *
+     * @returns true if any of them concern this interface
+     */
+    virtual bool process_events();
+
+    /**
+     * Appends the sockets notifications and responses arrive on to `fds`
+     */
+    virtual void events_fds(vector<struct pollfd>& fds) const;
+
+    connectivity_check& connectivity();
 
     string ip() const;
     string ip6() const;
@@ -97,12 +246,32 @@ namespace net {
     void check_tuntap_or_bridge();
     bool test_interface() const;
     string format_speedrate(float bytes_diff, int minwidth, const string& unit) const;
-    void query_ip6();
+
+    int request(uint16_t type, bool dump, const void* payload, size_t size, const rtnl::callback_t& callback);
+    bool query_stats(bool accumulate);
+    bool query_link();
+    bool query_addresses();
 
     const logger& m_log;
     unique_ptr<file_descriptor> m_socketfd;
     link_status m_status{};
     string m_interface;
+    unsigned int m_ifindex{0};
+
+    /**
+     * rtnetlink sockets, one subscribed to link and address notifications
+     * and one for requests
+     */
+    unique_ptr<file_descriptor> m_events_fd;
+    unique_ptr<file_descriptor> m_request_fd;
+    uint32_t m_request_sequence{0};
+    vector<char> m_buffer;
+
+    bool m_link_changed{true};
+    bool m_addresses_changed{true};
+    unsigned char m_operstate{0};
+
+    connectivity_check m_connectivity;
     bool m_tuntap{false};
     bool m_bridge{false};
     bool m_unknown_up{false};
@@ -128,18 +297,32 @@ namespace net {
 #if WITH_LIBNL
   // class : wireless_network {{{
 
+  /**
+   * Scan results are requested on every query without waiting for them, the
+   * response is read by process_events() (or the next query). nl80211
+   * notifications about new scan results and (dis)connects request new scan
+   * results right away.
+   */
   class wireless_network : public network {
    public:
-    wireless_network(string interface) : network(interface), m_ifid(if_nametoindex(interface.c_str())){};
+    explicit wireless_network(string interface);
 
     bool query(bool accumulate = false) override;
     bool connected() const override;
+    bool process_events() override;
+    void events_fds(vector<struct pollfd>& fds) const override;
     string essid() const;
     int signal() const;
     int quality() const;
 
    protected:
     static int scan_cb(struct nl_msg* msg, void* instance);
+    static int finish_cb(struct nl_msg* msg, void* instance);
+    static int event_cb(struct nl_msg* msg, void* instance);
+
+    bool open_sockets();
+    bool request_scan();
+    bool receive(struct nl_sock* socket);
 
     bool associated_or_joined(struct nlattr** bss);
     void parse_essid(struct nlattr** bss);
@@ -148,7 +331,20 @@ namespace net {
     void parse_signal(struct nlattr** bss);
 
    private:
-    unsigned int m_ifid{};
+    using socket_t = unique_ptr<struct nl_sock, void (*)(struct nl_sock*)>;
+
+    /**
+     * Generic netlink sockets for requests and for nl80211 notifications,
+     * kept open for the lifetime of the adapter
+     */
+    socket_t m_socket{nullptr, nullptr};
+    socket_t m_events{nullptr, nullptr};
+    int m_family{-1};
+
+    bool m_scan_pending{false};
+    bool m_refresh{false};
+    bool m_wake_on_scan{false};
+
     string m_essid{};
     int m_frequency{};
     quality_range m_signalstrength{};
@@ -161,7 +357,7 @@ namespace net {
 
   class wireless_network : public network {
    public:
-    wireless_network(string interface) : network(interface) {}
+    explicit wireless_network(string interface) : network(interface) {}
 
     bool query(bool accumulate = false) override;
     bool connected() const override;
@@ -176,6 +372,13 @@ namespace net {
 
    private:
     shared_ptr<wireless_info> m_info{};
+
+    /**
+     * Only read again after reading the statistics failed
+     */
+    iwrange m_range{};
+    bool m_range_valid{false};
+
     string m_essid{};
     quality_range m_signalstrength{};
     quality_range m_linkquality{};
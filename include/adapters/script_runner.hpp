@@ -6,11 +6,30 @@
 
 #include "common.hpp"
 #include "components/logger.hpp"
+#include "utils/command.hpp"
+#include "utils/file.hpp"
+#include "utils/wakeup_fd.hpp"
 
 POLYBAR_NS
 
 class script_runner {
  public:
+  enum class mode {
+    /**
+     * Run the script on every interval and use the first line it prints
+     */
+    INTERVAL,
+    /**
+     * Run the script once and use every line it prints
+     */
+    TAIL,
+    /**
+     * Keep the script running, on every interval write a request line to its
+     * stdin and use the line it responds with
+     */
+    COPROCESS,
+  };
+
   struct data {
     int counter{0};
     int pid{-1};
@@ -21,8 +40,8 @@ class script_runner {
   using on_update = std::function<void(const data&)>;
   using interval = std::chrono::duration<double>;
 
-  script_runner(on_update on_update, const string& exec, const string& exec_if, bool tail, interval interval_success,
-      interval interval_fail, const vector<pair<string, string>>& env);
+  script_runner(on_update on_update, const string& exec, const string& exec_if, mode mode, interval interval_success,
+      interval interval_fail, interval timeout, const vector<pair<string, string>>& env);
 
   bool check_condition() const;
   interval process();
@@ -37,7 +56,10 @@ class script_runner {
   bool set_output(string&&);
   bool set_exit_status(int);
 
+  bool read_tail(int fd, string& buffer);
+
   interval run_tail();
+  interval run_coprocess();
   interval run();
 
  private:
@@ -47,13 +69,25 @@ class script_runner {
 
   const string m_exec;
   const string m_exec_if;
-  const bool m_tail;
+  const mode m_mode;
   const interval m_interval_success;
   const interval m_interval_fail;
+  const interval m_timeout;
   const vector<pair<string, string>> m_env;
 
   data m_data;
+
+  /**
+   * Script kept running in coprocess mode
+   */
+  unique_ptr<command<output_policy::REDIRECTED>> m_coprocess;
+
   std::atomic_bool m_stopping{false};
+
+  /**
+   * Notified by stop() to interrupt tail scripts and coprocess requests
+   */
+  wakeup_fd m_wakeup;
 };
 
 POLYBAR_NS_END
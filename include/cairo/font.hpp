@@ -1,7 +1,12 @@
 #pragma once
 
 #include <cairo/cairo-ft.h>
+#include <sys/stat.h>
 
+#include <cstdlib>
+#include <functional>
+
+#include "cairo/font_cache.hpp"
 #include "cairo/types.hpp"
 #include "cairo/utils.hpp"
 #include "common.hpp"
@@ -53,39 +58,28 @@ class font {
 
 /**
  * @brief Font based on fontconfig/freetype
+ *
+ * The font is loaded lazily: the fontconfig match only happens once the font
+ * is asked whether it has a glyph for some character and the scaled font is
+ * only created once something is drawn with it. If the match is in the
+ * font_cache, fontconfig is never asked to match anything.
  */
 class font_fc : public font {
  public:
-  explicit font_fc(cairo_t* cairo, FcPattern* pattern, double offset, double dpi_x, double dpi_y)
-      : font(cairo, offset), m_pattern(pattern) {
-    cairo_matrix_t fm;
-    cairo_matrix_t ctm;
-    cairo_matrix_init_scale(&fm, size(dpi_x), size(dpi_y));
-    cairo_get_matrix(m_cairo, &ctm);
-
-    auto fontface = cairo_ft_font_face_create_for_pattern(m_pattern);
-    auto opts = cairo_font_options_create();
-    m_scaled = cairo_scaled_font_create(fontface, &fm, &ctm, opts);
-    cairo_font_options_destroy(opts);
-    cairo_font_face_destroy(fontface);
-
-    auto status = cairo_scaled_font_status(m_scaled);
-    if (status != CAIRO_STATUS_SUCCESS) {
-      throw application_error(sstream() << "cairo_scaled_font_create(): " << cairo_status_to_string(status));
+  explicit font_fc(cairo_t* cairo, string&& name, FcPattern* pattern, double offset, double dpi_x, double dpi_y,
+      shared_ptr<font_cache> cache)
+      : font(cairo, offset)
+      , m_config_pattern(pattern)
+      , m_name(move(name))
+      , m_key(font_cache::key(m_name, dpi_x, dpi_y))
+      , m_dpi_x(dpi_x)
+      , m_dpi_y(dpi_y)
+      , m_cache(move(cache)) {
+    auto entry = m_cache->find(m_key);
+    if (entry != nullptr && (m_pattern = FcNameParse(reinterpret_cast<const FcChar8*>(entry->pattern.c_str())))) {
+      m_chars = entry->chars;
+      m_has_chars = true;
     }
-
-    auto lock = make_unique<utils::ft_face_lock>(m_scaled);
-    auto face = static_cast<FT_Face>(*lock);
-
-    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) == FT_Err_Ok) {
-      return;
-    } else if (FT_Select_Charmap(face, FT_ENCODING_BIG5) == FT_Err_Ok) {
-      return;
-    } else if (FT_Select_Charmap(face, FT_ENCODING_SJIS) == FT_Err_Ok) {
-      return;
-    }
-
-    lock.reset();
   }
 
   ~font_fc() override {
@@ -95,10 +89,15 @@ class font_fc : public font {
     if (m_pattern != nullptr) {
       FcPatternDestroy(m_pattern);
     }
+    if (m_config_pattern != nullptr) {
+      FcPatternDestroy(m_config_pattern);
+    }
   }
 
   cairo_font_extents_t extents() override {
-    cairo_scaled_font_extents(m_scaled, &m_extents);
+    if (load()) {
+      cairo_scaled_font_extents(m_scaled, &m_extents);
+    }
     return m_extents;
   }
 
@@ -184,21 +183,20 @@ class font_fc : public font {
   }
 
   void use() override {
-    cairo_set_scaled_font(m_cairo, m_scaled);
+    if (load()) {
+      cairo_set_scaled_font(m_cairo, m_scaled);
+    }
   }
 
   size_t match(string_util::unicode_character& character) override {
-    auto lock = make_unique<utils::ft_face_lock>(m_scaled);
-    auto face = static_cast<FT_Face>(*lock);
-    return FT_Get_Char_Index(face, character.codepoint) ? 1 : 0;
+    return font_cache::contains(charset(), character.codepoint) ? 1 : 0;
   }
 
   size_t match(string_util::unicode_charlist& charlist) override {
-    auto lock = make_unique<utils::ft_face_lock>(m_scaled);
-    auto face = static_cast<FT_Face>(*lock);
+    const auto& chars = charset();
     size_t available_chars = 0;
     for (auto&& c : charlist) {
-      if (FT_Get_Char_Index(face, c.codepoint)) {
+      if (font_cache::contains(chars, c.codepoint)) {
         available_chars++;
       } else {
         break;
@@ -209,6 +207,10 @@ class font_fc : public font {
   }
 
   size_t render(const string& text, double x = 0.0, double y = 0.0) override {
+    if (!load()) {
+      return 0;
+    }
+
     cairo_glyph_t* glyphs{nullptr};
     cairo_text_cluster_t* clusters{nullptr};
     cairo_text_cluster_flags_t cf{};
@@ -265,13 +267,149 @@ class font_fc : public font {
   }
 
   void textwidth(const string& text, cairo_text_extents_t* extents) override {
-    cairo_scaled_font_text_extents(m_scaled, text.c_str(), extents);
+    if (load()) {
+      cairo_scaled_font_text_extents(m_scaled, text.c_str(), extents);
+    } else {
+      *extents = cairo_text_extents_t{};
+    }
   }
 
  protected:
+  /**
+   * Matches the configured pattern against the available fonts, unless the
+   * match was found in the cache.
+   */
+  FcPattern* resolve() const {
+    if (m_pattern == nullptr) {
+      FcDefaultSubstitute(m_config_pattern);
+      FcConfigSubstitute(nullptr, m_config_pattern, FcMatchPattern);
+
+      FcResult result;
+      m_pattern = FcFontMatch(nullptr, m_config_pattern, &result);
+
+      if (m_pattern == nullptr) {
+        throw application_error("Could not load font \"" + m_name + "\"");
+      }
+
+#ifdef DEBUG_FONTCONFIG
+      FcPatternPrint(m_pattern);
+#endif
+    }
+
+    return m_pattern;
+  }
+
+  /**
+   * Creates the scaled font on first use.
+   *
+   * If the font could not be loaded, an error is logged once and the font
+   * behaves as if it had no glyphs.
+   *
+   * @returns false if the font could not be loaded
+   */
+  bool load() {
+    if (!m_loaded) {
+      m_loaded = true;
+
+      try {
+        create_scaled_font();
+        logger::make().notice(
+            "Loaded font \"%s\" (name=%s, offset=%i, file=%s)", m_name, name(), m_offset, file());
+      } catch (const application_error& err) {
+        logger::make().err("Failed to load font \"%s\" (reason: %s)", m_name, err.what());
+
+        if (m_scaled != nullptr) {
+          cairo_scaled_font_destroy(m_scaled);
+          m_scaled = nullptr;
+        }
+
+        m_chars.clear();
+        m_has_chars = true;
+      }
+    }
+
+    return m_scaled != nullptr;
+  }
+
+  void create_scaled_font() {
+    resolve();
+
+    cairo_matrix_t fm;
+    cairo_matrix_t ctm;
+    cairo_matrix_init_scale(&fm, size(m_dpi_x), size(m_dpi_y));
+    cairo_get_matrix(m_cairo, &ctm);
+
+    auto fontface = cairo_ft_font_face_create_for_pattern(m_pattern);
+    auto opts = cairo_font_options_create();
+    m_scaled = cairo_scaled_font_create(fontface, &fm, &ctm, opts);
+    cairo_font_options_destroy(opts);
+    cairo_font_face_destroy(fontface);
+
+    auto status = cairo_scaled_font_status(m_scaled);
+    if (status != CAIRO_STATUS_SUCCESS) {
+      throw application_error(sstream() << "cairo_scaled_font_create(): " << cairo_status_to_string(status));
+    }
+
+    auto lock = make_unique<utils::ft_face_lock>(m_scaled);
+    auto face = static_cast<FT_Face>(*lock);
+
+    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) != FT_Err_Ok &&
+        FT_Select_Charmap(face, FT_ENCODING_BIG5) != FT_Err_Ok) {
+      FT_Select_Charmap(face, FT_ENCODING_SJIS);
+    }
+
+    if (!m_has_chars) {
+      // Collect all characters with a glyph in the selected charmap
+      FT_UInt index;
+      FT_ULong c = FT_Get_First_Char(face, &index);
+      while (index != 0) {
+        font_cache::add(m_chars, c);
+        c = FT_Get_Next_Char(face, c, &index);
+      }
+      m_has_chars = true;
+
+      store();
+    }
+  }
+
+  /**
+   * Adds the match and the charset to the font cache
+   */
+  void store() {
+    auto pattern = FcPatternDuplicate(m_pattern);
+    FcPatternDel(pattern, FC_CHARSET);
+    FcPatternDel(pattern, FC_LANG);
+    auto unparsed = FcNameUnparse(pattern);
+    FcPatternDestroy(pattern);
+
+    if (unparsed == nullptr) {
+      return;
+    }
+
+    m_cache->insert(m_key, {reinterpret_cast<char*>(unparsed), m_chars});
+    free(unparsed);
+
+    try {
+      m_cache->save();
+    } catch (const std::exception& err) {
+      logger::make().warn("Failed to write font cache (%s)", err.what());
+    }
+  }
+
+  /**
+   * @returns The characters this font has glyphs for, loads the font if they
+   *          are not cached
+   */
+  const font_cache::charset& charset() {
+    if (!m_has_chars) {
+      load();
+    }
+    return m_chars;
+  }
+
   string property(string&& property) const {
     FcChar8* file;
-    if (FcPatternGetString(m_pattern, property.c_str(), 0, &file) == FcResultMatch) {
+    if (FcPatternGetString(resolve(), property.c_str(), 0, &file) == FcResultMatch) {
       return string(reinterpret_cast<char*>(file));
     } else {
       return "";
@@ -280,29 +418,50 @@ class font_fc : public font {
 
   void property(string&& property, bool* dst) const {
     FcBool b;
-    FcPatternGetBool(m_pattern, property.c_str(), 0, &b);
+    FcPatternGetBool(resolve(), property.c_str(), 0, &b);
     *dst = b;
   }
 
   void property(string&& property, double* dst) const {
-    FcPatternGetDouble(m_pattern, property.c_str(), 0, dst);
+    FcPatternGetDouble(resolve(), property.c_str(), 0, dst);
   }
 
   void property(string&& property, int* dst) const {
-    FcPatternGetInteger(m_pattern, property.c_str(), 0, dst);
+    FcPatternGetInteger(resolve(), property.c_str(), 0, dst);
   }
 
  private:
   cairo_scaled_font_t* m_scaled{nullptr};
-  FcPattern* m_pattern{nullptr};
+
+  /**
+   * The configured pattern, only used for matching
+   */
+  FcPattern* m_config_pattern{nullptr};
+
+  /**
+   * The matched pattern, from the cache or from fontconfig
+   */
+  mutable FcPattern* m_pattern{nullptr};
+
+  string m_name;
+  string m_key;
+  double m_dpi_x;
+  double m_dpi_y;
+  shared_ptr<font_cache> m_cache;
+
+  bool m_loaded{false};
+  bool m_has_chars{false};
+  font_cache::charset m_chars;
 };
 
 /**
- * Match and create font from given fontconfig pattern
+ * Initialize fontconfig and FreeType once
  */
-inline decltype(auto) make_font(cairo_t* cairo, string&& fontname, double offset, double dpi_x, double dpi_y) {
+inline void init_fonts() {
   static bool fc_init{false};
-  if (!fc_init && !(fc_init = FcInit())) {
+  if (fc_init) {
+    return;
+  } else if (!(fc_init = FcInit())) {
     throw application_error("Could not load fontconfig");
   } else if (FT_Init_FreeType(&g_ftlib) != FT_Err_Ok) {
     throw application_error("Could not load FreeType");
@@ -312,6 +471,44 @@ inline decltype(auto) make_font(cairo_t* cairo, string&& fontname, double offset
     FT_Done_FreeType(g_ftlib);
     FcFini();
   });
+}
+
+/**
+ * Identifies the fontconfig state that font matches depend on
+ *
+ * Combines the fontconfig version with the modification times of all
+ * configuration files and cache directories. The cache directories change
+ * whenever fontconfig rebuilds a cache because fonts were added or removed.
+ */
+inline string fontconfig_generation() {
+  init_fonts();
+
+  string generation = to_string(FcGetVersion());
+  auto add_mtimes = [&](FcStrList* list) {
+    struct stat info {};
+    FcChar8* path;
+    while ((path = FcStrListNext(list)) != nullptr) {
+      if (stat(reinterpret_cast<const char*>(path), &info) == 0) {
+        generation += " " + to_string(info.st_mtim.tv_sec) + "." + to_string(info.st_mtim.tv_nsec);
+      }
+    }
+    FcStrListDone(list);
+  };
+
+  add_mtimes(FcConfigGetConfigFiles(nullptr));
+  add_mtimes(FcConfigGetCacheDirs(nullptr));
+
+  return to_string(std::hash<string>{}(generation));
+}
+
+/**
+ * Create a font for the given fontconfig pattern
+ *
+ * Only parses the pattern, matching happens once the font is used.
+ */
+inline decltype(auto) make_font(
+    cairo_t* cairo, string&& fontname, double offset, double dpi_x, double dpi_y, shared_ptr<font_cache> cache) {
+  init_fonts();
 
   auto pattern = FcNameParse((FcChar8*)fontname.c_str());
 
@@ -320,22 +517,7 @@ inline decltype(auto) make_font(cairo_t* cairo, string&& fontname, double offset
     throw application_error("Could not parse font \"" + fontname + "\"");
   }
 
-  FcDefaultSubstitute(pattern);
-  FcConfigSubstitute(nullptr, pattern, FcMatchPattern);
-
-  FcResult result;
-  FcPattern* match = FcFontMatch(nullptr, pattern, &result);
-  FcPatternDestroy(pattern);
-
-  if (match == nullptr) {
-    throw application_error("Could not load font \"" + fontname + "\"");
-  }
-
-#ifdef DEBUG_FONTCONFIG
-  FcPatternPrint(match);
-#endif
-
-  return make_shared<font_fc>(cairo, match, offset, dpi_x, dpi_y);
+  return make_shared<font_fc>(cairo, move(fontname), pattern, offset, dpi_x, dpi_y, move(cache));
 }
 } // namespace cairo
 
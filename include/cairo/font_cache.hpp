@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace cairo {
+/**
+ * @brief Persistent cache of fontconfig matches
+ *
+ * Maps a configured font pattern (together with the dpi) to the pattern
+ * fontconfig matched for it and to the set of characters the font has glyphs
+ * for. With a cache hit, fonts can be created and fallback fonts can be picked
+ * without asking fontconfig to match anything.
+ *
+ * The whole cache is dropped if the fontconfig generation (version,
+ * configuration files and font caches) differs from the one it was written
+ * with.
+ */
+class font_cache {
+ public:
+  /**
+   * @brief Inclusive range of unicode codepoints
+   */
+  using range = std::pair<uint32_t, uint32_t>;
+
+  /**
+   * @brief Sorted, non-overlapping ranges of codepoints
+   */
+  using charset = vector<range>;
+
+  struct entry {
+    /**
+     * Matched pattern as produced by FcNameUnparse (without charset)
+     */
+    string pattern;
+    charset chars;
+  };
+
+  /**
+   * Loads the cache from `path`.
+   *
+   * A missing or unreadable file or one written for a different generation
+   * results in an empty cache. If `path` is empty, the cache is never read
+   * from or written to disk.
+   */
+  font_cache(string path, string generation);
+
+  /**
+   * @returns The entry for the given key or nullptr if there is none
+   */
+  const entry* find(const string& key) const;
+
+  void insert(const string& key, entry&& value);
+
+  /**
+   * Writes the cache to disk if it was modified since it was loaded.
+   *
+   * @throws system_error if the file could not be written
+   */
+  void save();
+
+  static string key(const string& pattern, double dpi_x, double dpi_y);
+
+  /**
+   * Appends `codepoint` to the charset, codepoints must be added in ascending
+   * order.
+   */
+  static void add(charset& chars, uint32_t codepoint);
+  static bool contains(const charset& chars, uint32_t codepoint);
+
+  /**
+   * @returns $XDG_CACHE_HOME/polybar/fonts (falling back to ~/.cache) or an
+   *          empty string if neither is set
+   */
+  static string default_path();
+
+ private:
+  void load();
+
+  static string serialize(const charset& chars);
+  static bool deserialize(const string& str, charset& chars);
+
+  string m_path;
+  string m_generation;
+  std::unordered_map<string, entry> m_entries;
+  bool m_dirty{false};
+};
+} // namespace cairo
+
+POLYBAR_NS_END
@@ -12,6 +12,7 @@
 #include "settings.hpp"
 #include "tags/action_context.hpp"
 #include "utils/math.hpp"
+#include "utils/perf.hpp"
 #include "x11/types.hpp"
 #include "x11/window.hpp"
 
@@ -36,6 +37,14 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
                 evt::leave_notify, evt::motion_notify, evt::destroy_notify, evt::client_message, evt::configure_notify>,
             public signal_receiver<SIGN_PRIORITY_BAR, signals::ui::dim_window> {
  public:
+  /**
+   * Per-frame durations of parsing the bar contents and of finishing the render
+   */
+  struct render_stats {
+    perf_util::histogram parse;
+    perf_util::histogram render;
+  };
+
   using make_type = unique_ptr<bar>;
   static make_type make(eventloop::loop&, const config&, bool only_initialize_values = false);
 
@@ -44,6 +53,7 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   ~bar();
 
   const bar_settings& settings() const;
+  const render_stats& stats() const;
 
   void start(const string& tray_module_name);
 
@@ -106,6 +116,13 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
    */
   string m_cursor{};
 
+  /**
+   * Cursor used when the pointer is not above any action block.
+   *
+   * Depends only on the bar-level fallback actions and is computed once.
+   */
+  string m_fallback_cursor{"default"};
+
   string m_lastinput{};
   std::set<mousebtn> m_dblclicks;
 
@@ -115,6 +132,8 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   eventloop::timer_handle_t m_dim_timer{m_loop.handle<eventloop::TimerHandle>()};
 
   bool m_visible{true};
+
+  render_stats m_stats;
 };
 
 POLYBAR_NS_END
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <exception>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <typeindex>
 #include <unordered_map>
 
 #include "common.hpp"
@@ -25,10 +30,27 @@ using file_list = vector<string>;
 class config {
  public:
   explicit config(const logger& logger, string&& path, string&& bar)
-      : m_log(logger), m_file(move(path)), m_barname(move(bar)){};
+      : m_log(logger), m_file(move(path)), m_barname(move(bar)), m_section(BAR_PREFIX + m_barname){};
+
+  /**
+   * Identifies a parameter in the resolved config snapshot.
+   *
+   * Reading a parameter through a handle does not need any section or key
+   * lookups.
+   */
+  class value_handle {
+   public:
+    value_handle() = default;
+
+   private:
+    friend class config;
+    explicit value_handle(size_t index) : m_index(index) {}
+
+    size_t m_index{0};
+  };
 
   const string& filepath() const;
-  string section() const;
+  const string& section() const;
 
   static constexpr const char* BAR_PREFIX = "bar/";
 
@@ -41,8 +63,49 @@ class config {
 
   void set_included(file_list included);
 
+  /**
+   * @brief Resolves all parameters into the config snapshot.
+   *
+   * Must be called once all sections are set and the xresource manager is
+   * set up. Afterwards, all references are already dereferenced and
+   * parameter lookups no longer go through dereference().
+   *
+   * Chains of local references are followed once in dependency order, every
+   * parameter is evaluated exactly once. Parameters that are part of a
+   * reference cycle (or refer to one) fail with a value_error.
+   */
+  void resolve();
+
   file_list get_included_files() const;
 
+  /**
+   * @brief Absolute paths of all files used in ${file:...} references
+   */
+  file_list get_referenced_files() const;
+
+  /**
+   * @brief Whether any parameter uses an ${xrdb:...} reference
+   */
+  bool has_xrdb_references() const;
+
+  /**
+   * @brief Creates a resolved copy of this config with some references re-read
+   *
+   * ${file:...} references to any of `files` are read again. If `xrdb` is set,
+   * the X resource database is reloaded and all ${xrdb:...} references are
+   * looked up again. All other references keep their previous values.
+   */
+  config refresh(const file_list& files, bool xrdb) const;
+
+  /**
+   * Returns true if the given section has the same parameters and values in
+   * both configs.
+   *
+   * Values are compared after dereferencing, so a changed parameter that is
+   * referenced from the section also counts as a change.
+   */
+  bool section_equals(const string& section, const config& other) const;
+
   void warn_deprecated(const string& section, const string& key, string replacement = "") const;
 
   /**
@@ -68,6 +131,10 @@ class config {
    */
   template <typename T = string>
   T get(const string& section, const string& key) const {
+    if (m_resolved) {
+      return get<T>(handle(section, key));
+    }
+
     auto it = m_sections.find(section);
     if (it == m_sections.end()) {
       throw key_error("Missing section \"" + section + "\"");
@@ -78,6 +145,46 @@ class config {
     return convert<T>(dereference(section, key, it->second.at(key)));
   }
 
+  /**
+   * Get the handle of a parameter in the resolved snapshot
+   *
+   * @throws key_error If the parameter does not exist
+   */
+  value_handle handle(const string& section, const string& key) const;
+
+  /**
+   * Get value of a resolved parameter.
+   *
+   * Conversions to non-string types are cached per type.
+   */
+  template <typename T = string>
+  T get(value_handle handle) const {
+    const auto& entry = m_snapshot.at(handle.m_index);
+
+    if (entry.error) {
+      std::rethrow_exception(entry.error);
+    }
+
+    if constexpr (std::is_same<T, string>::value || std::is_pointer<T>::value) {
+      return convert<T>(string{entry.value});
+    } else {
+      const std::type_index type{typeid(T)};
+      {
+        std::lock_guard<std::mutex> guard(*m_snapshot_lock);
+        auto it = entry.converted.find(type);
+        if (it != entry.converted.end()) {
+          return *std::static_pointer_cast<const T>(it->second);
+        }
+      }
+
+      T value{convert<T>(string{entry.value})};
+
+      std::lock_guard<std::mutex> guard(*m_snapshot_lock);
+      entry.converted.emplace(type, std::make_shared<const T>(value));
+      return value;
+    }
+  }
+
   /**
    * Get value of a variable by section and parameter name
    * with a default value in case the parameter isn't defined
@@ -85,6 +192,10 @@ class config {
   template <typename T = string>
   T get(const string& section, const string& key, const T& default_value) const {
     try {
+      if (m_resolved) {
+        return get<T>(handle(section, key));
+      }
+
       string string_value{get<string>(section, key)};
       return convert<T>(dereference(move(section), move(key), move(string_value)));
     } catch (const key_error& err) {
@@ -254,18 +365,83 @@ class config {
   string dereference_file(string var) const;
 
  private:
+  /**
+   * @returns The snapshot index of the parameter `value` refers to, if it is a
+   *          plain local reference (no fallback) to an existing parameter.
+   *          SIZE_MAX otherwise.
+   */
+  size_t local_reference(const string& section, const string& value) const;
+
+  /**
+   * A fully dereferenced parameter value
+   */
+  struct snapshot_entry {
+    string value;
+
+    /**
+     * Set if dereferencing failed, rethrown whenever the value is accessed
+     */
+    std::exception_ptr error;
+
+    /**
+     * Previously converted values by type, guarded by m_snapshot_lock
+     */
+    mutable std::unordered_map<std::type_index, shared_ptr<const void>> converted;
+  };
+
   const logger& m_log;
   string m_file;
   string m_barname;
+  string m_section;
   sectionmap_t m_sections{};
 
+  /**
+   * Value of a ${file:...} or ${xrdb:...} reference
+   */
+  struct reference {
+    /**
+     * Referenced file, empty for ${xrdb:...}
+     */
+    string file;
+    string value;
+    std::exception_ptr error;
+  };
+
+  /**
+   * Values of ${file:...} and ${xrdb:...} references by the parameter value
+   * containing them.
+   *
+   * Filled by resolve() so that each reference is only read once, no matter
+   * how many parameters use it.
+   */
+  std::unordered_map<string, reference> m_references;
+
+  /**
+   * Resolved parameters, indexed by value_handle
+   */
+  vector<snapshot_entry> m_snapshot;
+
+  /**
+   * Maps section and key names to an index into m_snapshot
+   */
+  std::unordered_map<string, std::unordered_map<string, size_t>> m_snapshot_index;
+
+  /**
+   * Conversions are cached lazily from multiple threads.
+   *
+   * Held through a pointer so that config stays movable.
+   */
+  unique_ptr<std::mutex> m_snapshot_lock{make_unique<std::mutex>()};
+
+  bool m_resolved{false};
+
   /**
    * Absolute path of all files that were parsed in the process of parsing the
    * config (Path of the main config file also included)
    */
   file_list m_included;
 #if WITH_XRM
-  unique_ptr<xresource_manager> m_xrm;
+  shared_ptr<xresource_manager> m_xrm;
 #endif
 };
 
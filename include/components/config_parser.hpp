@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <exception>
 #include <set>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "components/config.hpp"
@@ -114,13 +117,50 @@ class config_parser {
   sectionmap_t create_sectionmap();
 
   /**
-   * @brief Parses the given file, extracts key-value pairs and section
-   *        headers and adds them onto the `lines` vector
+   * @brief Result of reading a single file, before includes are expanded
+   */
+  struct parsed_file {
+    /**
+     * Key-value pairs and section headers, without include directives
+     */
+    vector<line_t> lines;
+
+    /**
+     * Absolute paths of all included files, each with the number of lines
+     * that precede the include directive
+     */
+    vector<std::pair<size_t, string>> includes;
+
+    /**
+     * Set if the file could not be read or parsed. Rethrown once the file is
+     * actually included so that errors are reported in config order.
+     */
+    std::exception_ptr error;
+  };
+
+  /**
+   * @brief Reads the main config file and all (transitively) included files
    *
-   * This method directly resolves `include-file` directives and checks for
-   * cyclic dependencies
+   * Files are read in waves: all files included by the files of one wave are
+   * read concurrently in the next one. Each file is only read once.
+   */
+  void read_files();
+
+  /**
+   * @brief Reads and parses a single file, without following includes
    *
-   * `file` is expected to be an already resolved absolute path
+   * Safe to call concurrently as long as m_files is not modified.
+   */
+  parsed_file read_file(const string& file, int file_index);
+
+  /**
+   * @brief Appends the lines of the given file and the files it includes to
+   *        the `lines` vector
+   *
+   * This method resolves `include-file` and `include-directory` directives in
+   * the order they appear in and checks for cyclic dependencies
+   *
+   * `file` is expected to have been read by read_files()
    */
   void parse_file(const string& file, file_list path);
 
@@ -222,7 +262,7 @@ class config_parser {
    *
    * Is set to true if any ${xrdb...} references are found
    */
-  bool use_xrm{false};
+  std::atomic_bool use_xrm{false};
 
   const logger& m_log;
 
@@ -239,6 +279,11 @@ class config_parser {
    */
   vector<line_t> m_lines;
 
+  /**
+   * @brief All files read by read_files(), by absolute path
+   */
+  std::unordered_map<string, parsed_file> m_parsed;
+
   /**
    * @brief None of these characters can be used in the key and section names
    */
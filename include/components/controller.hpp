@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include <queue>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "components/eventloop.hpp"
@@ -11,6 +12,8 @@
 #include "settings.hpp"
 #include "utils/actions.hpp"
 #include "utils/file.hpp"
+#include "utils/memory.hpp"
+#include "utils/perf.hpp"
 #include "x11/types.hpp"
 
 POLYBAR_NS
@@ -24,6 +27,7 @@ class bar;
 class config;
 class connection;
 class inotify_watch;
+class launcher;
 class logger;
 class signal_emitter;
 namespace modules {
@@ -36,12 +40,15 @@ using modulemap_t = std::map<alignment, vector<module_t>>;
 class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eventqueue::exit_reload,
                        signals::eventqueue::notify_change, signals::eventqueue::notify_forcechange,
                        signals::eventqueue::check_state, signals::ipc::action, signals::ipc::command,
-                       signals::ipc::hook, signals::ui::button_press, signals::ui::update_background> {
+                       signals::ipc::hook, signals::ipc::stats, signals::ui::button_press,
+                       signals::ui::update_background>,
+                   public xpp::event::sink<evt::property_notify> {
  public:
   using make_type = unique_ptr<controller>;
-  static make_type make(bool has_ipc, eventloop::loop&, const config&);
+  static make_type make(bool has_ipc, eventloop::loop&, const config&, launcher* click_launcher = nullptr);
 
-  explicit controller(connection&, signal_emitter&, const logger&, const config&, bool has_ipc, eventloop::loop&);
+  explicit controller(connection&, signal_emitter&, const logger&, const config&, bool has_ipc, eventloop::loop&,
+      launcher* click_launcher = nullptr);
   ~controller();
 
   bool run(bool writeback, string snapshot_dst, bool confwatch);
@@ -56,7 +63,12 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
 
   void conn_cb();
   void create_config_watcher(const string& filename);
+  void create_reference_watcher(const string& filename);
+  void watch_config(const config& conf);
   void confwatch_handler(const char* fname);
+  void reference_handler(const string& filename);
+  void reload_config();
+  void refresh_references();
   void notifier_handler();
   void screenshot_handler();
 
@@ -69,6 +81,13 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
 
   void update_reload(bool reload);
 
+  void start_confwatch_timer();
+  void start_reaper();
+  bool apply_config(const shared_ptr<config>& conf);
+  const config& current_config() const;
+
+  void handle(const evt::property_notify& evt) override;
+
   bool on(const signals::eventqueue::notify_change& evt) override;
   bool on(const signals::eventqueue::notify_forcechange& evt) override;
   bool on(const signals::eventqueue::exit_reload& evt) override;
@@ -77,6 +96,7 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
   bool on(const signals::ipc::action& evt) override;
   bool on(const signals::ipc::command& evt) override;
   bool on(const signals::ipc::hook& evt) override;
+  bool on(const signals::ipc::stats& evt) override;
   bool on(const signals::ui::update_background& evt) override;
 
  private:
@@ -90,11 +110,16 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
     notifications_t() : quit(false), reload(false), update(false), force_update(false), inputdata(queue<string>{}) {}
   };
 
-  size_t setup_modules(alignment align);
+  size_t setup_modules();
+
+  void read_x_events();
+  void compress_x_events();
 
   bool forward_action(const actions_util::action& cmd);
   bool try_forward_legacy_action(const string& cmd);
 
+  string stats_report(bool json) const;
+
   connection& m_connection;
   signal_emitter& m_sig;
   const logger& m_log;
@@ -104,6 +129,11 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
   bool m_has_ipc;
   string m_tray_module_name;
 
+  /**
+   * @brief Runs shell commands for input data, if enabled
+   */
+  launcher* m_launcher;
+
   /**
    * @brief Async handle to notify the eventloop
    *
@@ -126,6 +156,14 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
    */
   std::mutex m_notification_mutex{};
 
+  /**
+   * @brief X events drained from the connection in the current loop iteration
+   *
+   * Kept as a member so that its storage is reused across iterations. Entries
+   * set to nullptr were superseded by a newer event and are not dispatched.
+   */
+  vector<malloc_unique_ptr<xcb_generic_event_t>> m_x_events;
+
   /**
    * @brief Destination path of generated snapshot
    */
@@ -136,16 +174,80 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
    */
   bool m_writeback{false};
 
+  /**
+   * @brief Watchers for the config file and all included files
+   */
+  vector<eventloop::fs_event_handle_t> m_config_watchers;
+
+  /**
+   * @brief Delays reloading the config until the watched files stop changing
+   */
+  eventloop::timer_handle_t m_confwatch_timer;
+
+  /**
+   * @brief Reaps shell commands started for input data once they exit
+   */
+  eventloop::signal_handle_t m_reaper;
+
+  /**
+   * @brief Whether the config files changed since the last reload
+   */
+  bool m_config_changed{false};
+
+  /**
+   * @brief Files used in ${file:...} references that changed since the last reload
+   */
+  file_list m_changed_references;
+
+  /**
+   * @brief Whether the X resources changed since the last reload
+   */
+  bool m_xrdb_changed{false};
+
+  /**
+   * @brief Whether we listen for changes of the RESOURCE_MANAGER property
+   */
+  bool m_xrdb_watched{false};
+
+  /**
+   * @brief The most recently loaded config, unset until the first reload
+   */
+  shared_ptr<const config> m_current_config;
+
+  /**
+   * @brief Configs of modules that were recreated by a config reload, by module name
+   *
+   * All other modules use m_conf. Must outlive the modules.
+   */
+  std::unordered_map<string, shared_ptr<const config>> m_module_configs;
+
   /**
    * @brief Loaded modules
    */
   vector<module_t> m_modules;
 
+  /**
+   * @brief Loaded modules indexed by their name (w/o 'module/' prefix)
+   *
+   * Used to route actions without scanning all modules.
+   */
+  std::unordered_map<string, vector<module_t>> m_modules_by_name;
+
+  /**
+   * @brief First loaded module of each module type
+   */
+  std::unordered_map<string, module_t> m_modules_by_type;
+
   /**
    * @brief Loaded modules grouped by block
    */
   modulemap_t m_blocks;
 
+  /**
+   * @brief Duration of process_update calls
+   */
+  perf_util::histogram m_update_time;
+
   /**
    * @brief Flag to trigger reload after shutdown
    */
@@ -203,6 +203,7 @@ namespace eventloop {
 
     void init();
     void start(int signum, cb&& user_cb);
+    void stop();
 
    protected:
     void reset_callbacks() override;
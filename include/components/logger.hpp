@@ -1,13 +1,17 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
-#include <map>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
 
 #include "common.hpp"
 #include "settings.hpp"
+#include "utils/ring_buffer.hpp"
 
 #ifndef STDOUT_FILENO
 #define STDOUT_FILENO 1
@@ -33,6 +37,7 @@ class logger {
   static make_type make(loglevel level = loglevel::NONE);
 
   explicit logger(loglevel level);
+  ~logger();
 
   const logger& operator=(const logger&) const {
     return *this;
@@ -42,6 +47,9 @@ class logger {
 
   void verbosity(loglevel level);
 
+  void async(bool enabled);
+  size_t dropped() const;
+
 #ifdef DEBUG_LOGGER // {{{
   template <typename... Args>
   void trace(const string& message, Args&&... args) const {
@@ -130,7 +138,18 @@ class logger {
 #pragma GCC diagnostic ignored "-Wformat-security"
 #endif // }}}
 
-    dprintf(m_fd, (m_prefixes.at(level) + format + m_suffixes.at(level) + "\n").c_str(), convert(values)...);
+    char buffer[LINE_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), format.c_str(), convert(values)...);
+
+    if (length < 0) {
+      return;
+    } else if (static_cast<size_t>(length) < sizeof(buffer)) {
+      write(level, buffer, length);
+    } else {
+      string message(length, '\0');
+      snprintf(&message[0], length + 1, format.c_str(), convert(values)...);
+      write(level, message.data(), length);
+    }
 
 #if defined(__clang__) // {{{
 #pragma clang diagnostic pop
@@ -140,6 +159,28 @@ class logger {
   }
 
  private:
+  /**
+   * Size of a formatted line, including prefix and suffix. Longer messages
+   * are formatted on the heap in synchronous mode and truncated in
+   * asynchronous mode.
+   */
+  static constexpr size_t LINE_SIZE{1024};
+
+  /**
+   * Number of lines buffered in asynchronous mode before messages are dropped
+   */
+  static constexpr size_t QUEUE_SIZE{512};
+
+  struct line {
+    size_t size;
+    char data[LINE_SIZE];
+  };
+
+  void write(loglevel level, const char* message, size_t length) const;
+  void flush_loop();
+  void flush_queue(string& batch);
+  void write_fd(const char* data, size_t length) const;
+
   /**
    * Logger verbosity level
    */
@@ -153,12 +194,25 @@ class logger {
   /**
    * Loglevel specific prefixes
    */
-  std::map<loglevel, string> m_prefixes;
+  std::array<string, 6> m_prefixes;
+
+  /**
+   * Loglevel specific suffixes, including the trailing newline
+   */
+  std::array<string, 6> m_suffixes;
 
   /**
-   * Loglevel specific suffixes
+   * Queue of formatted lines, only allocated in asynchronous mode
    */
-  std::map<loglevel, string> m_suffixes;
+  unique_ptr<mpsc_ring_buffer<line>> m_queue;
+  std::atomic_bool m_async{false};
+  mutable std::atomic<size_t> m_dropped{0};
+  size_t m_reported_dropped{0};
+
+  std::thread m_flusher;
+  std::mutex m_flush_mutex;
+  std::condition_variable m_flush_cv;
+  bool m_flush_stop{false};
 };
 
 POLYBAR_NS_END
@@ -22,11 +22,41 @@ namespace drawtypes {
     operator bool();
 
    protected:
+    friend class ramp_table;
+
+    size_t index_by_percentage_with_borders(int percentage) const;
+
     vector<label_t> m_icons;
   };
 
   using ramp_t = shared_ptr<ramp>;
 
+  /**
+   * @brief Precomputed results of ramp::get_by_percentage_with_borders for fixed borders
+   *
+   * The ramp only distinguishes whole percentages between the borders, so
+   * all possible results fit into a small table and looking up a value does
+   * not need to do any work on the ramp.
+   */
+  class ramp_table {
+   public:
+    ramp_table() = default;
+    explicit ramp_table(const ramp& r, float min, float max);
+
+    /**
+     * @returns The same label as `r.get_by_percentage_with_borders(value, min, max)`
+     */
+    const label_t& get(float value) const;
+
+   private:
+    /**
+     * Label at or below `min` followed by the labels for 0% to 100%
+     */
+    vector<label_t> m_labels;
+    float m_min{0};
+    float m_max{0};
+  };
+
   ramp_t load_ramp(const config& conf, const string& section, string name, bool required = true);
 }  // namespace drawtypes
 
@@ -72,6 +72,15 @@ namespace signals {
     struct action : public detail::value_signal<action, string> {
       using base_type::base_type;
     };
+
+    /// Requests a performance report, the receiver writes it to `output`
+    struct stats_request {
+      string format;
+      string* output;
+    };
+    struct stats : public detail::value_signal<stats, stats_request> {
+      using base_type::base_type;
+    };
   } // namespace ipc
 
   namespace ui {
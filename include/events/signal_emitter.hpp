@@ -1,19 +1,87 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 #include "common.hpp"
 #include "components/logger.hpp"
 #include "events/signal_receiver.hpp"
 
 POLYBAR_NS
 
+namespace detail {
+  struct receiver_list_base {
+    virtual ~receiver_list_base() {}
+  };
+
+  /**
+   * @brief Receivers of a single signal type, ordered by priority
+   *
+   * Never modified once published, attaching or detaching replaces the whole
+   * list.
+   */
+  template <typename Signal>
+  struct receiver_list : public receiver_list_base {
+    vector<std::pair<signal_receiver_interface::prio, signal_receiver_impl<Signal>*>> receivers;
+  };
+
+  /**
+   * @brief Static slot holding the current receiver list of a signal type
+   */
+  template <typename Signal>
+  struct signal_slot {
+    static std::atomic<const receiver_list<Signal>*> receivers;
+  };
+
+  template <typename Signal>
+  std::atomic<const receiver_list<Signal>*> signal_slot<Signal>::receivers{nullptr};
+
+  /**
+   * @brief Emit state of a single thread
+   */
+  struct emit_slot {
+    /**
+     * Odd while the thread is inside an emit call
+     */
+    std::atomic<uint64_t> sequence{0};
+
+    /**
+     * Set while the thread waits for a grace period from within an emit call
+     */
+    std::atomic_bool waiting{false};
+
+    /**
+     * Nesting depth of emit calls, only used by the owning thread
+     */
+    size_t depth{0};
+  };
+
+  /**
+   * @returns The emit state of the calling thread
+   */
+  emit_slot& current_emit_slot();
+} // namespace detail
+
 /**
- * @brief Holds all signal receivers attached to the emitter
+ * @brief Serializes changes to the receiver lists
  */
-extern signal_receivers_t g_signal_receivers;
+extern std::mutex g_signal_update_lock;
 
 /**
  * Wrapper used to delegate emitted signals
  * to attached signal receivers
+ *
+ * Signals can be emitted from any thread. Apart from the first emit in each
+ * thread, emitting does not lock or allocate, it only loads the receiver list
+ * of the signal type. Attaching and detaching
+ * receivers is serialized and publishes a new list.
+ *
+ * Once detach() returns, emits in other threads no longer call the receiver.
+ * It waits for emits that may still be using the old list. A receiver can
+ * detach itself from within its handler. The emit that called the handler
+ * may still reach the rest of the old list, which is freed after that emit
+ * returns.
  */
 class signal_emitter {
  public:
@@ -25,12 +93,17 @@ class signal_emitter {
 
   template <typename Signal>
   bool emit(const Signal& sig) {
+    emit_guard guard;
+    const auto* list = detail::signal_slot<Signal>::receivers.load();
+
+    if (list == nullptr) {
+      return false;
+    }
+
     try {
-      if (g_signal_receivers.find(id<Signal>()) != g_signal_receivers.end()) {
-        for (auto&& item : g_signal_receivers.at(id<Signal>())) {
-          if (item.second->on(sig)) {
-            return true;
-          }
+      for (const auto& item : list->receivers) {
+        if (item.second->on(sig)) {
+          return true;
         }
       }
     } catch (const std::exception& e) {
@@ -56,52 +129,91 @@ class signal_emitter {
   }
 
  protected:
-  template <typename Signal>
-  std::type_index id() const {
-    return typeid(Signal);
-  }
+  struct emit_guard {
+    emit_guard() : slot(detail::current_emit_slot()) {
+      if (slot.depth++ == 0) {
+        slot.sequence++;
+      }
+    }
+    ~emit_guard() {
+      if (--slot.depth == 0) {
+        slot.sequence++;
+      }
+    }
+
+    detail::emit_slot& slot;
+  };
 
   template <typename Receiver, typename Signal>
   void attach(Receiver* s) {
-    attach(s, id<Signal>());
+    signal_receiver_impl<Signal>* receiver = s;
+    auto prio = s->priority();
+
+    update<Signal>([&](auto& receivers) {
+      // Behind all receivers with the same priority, like a multimap
+      auto it = std::upper_bound(receivers.begin(), receivers.end(), prio,
+          [](signal_receiver_interface::prio p, const auto& item) { return p < item.first; });
+      receivers.emplace(it, prio, receiver);
+    });
   }
 
   template <typename Receiver, typename Signal, typename Next, typename... Signals>
   void attach(Receiver* s) {
-    attach(s, id<Signal>());
+    attach<Receiver, Signal>(s);
     attach<Receiver, Next, Signals...>(s);
   }
 
-  void attach(signal_receiver_interface* s, std::type_index id) {
-    g_signal_receivers[id].emplace(s->priority(), s);
-  }
-
   template <typename Receiver, typename Signal>
   void detach(Receiver* s) {
-    detach(s, id<Signal>());
+    signal_receiver_impl<Signal>* receiver = s;
+
+    update<Signal>([&](auto& receivers) {
+      receivers.erase(std::remove_if(receivers.begin(), receivers.end(),
+                          [&](const auto& item) { return item.second == receiver; }),
+          receivers.end());
+    });
   }
 
   template <typename Receiver, typename Signal, typename Next, typename... Signals>
   void detach(Receiver* s) {
-    detach(s, id<Signal>());
+    detach<Receiver, Signal>(s);
     detach<Receiver, Next, Signals...>(s);
   }
 
-  void detach(signal_receiver_interface* d, std::type_index id) {
-    try {
-      auto& prio_map = g_signal_receivers.at(id);
-      const auto& prio_sink_pair = prio_map.equal_range(d->priority());
-
-      for (auto it = prio_sink_pair.first; it != prio_sink_pair.second;) {
-        if (d == it->second) {
-          it = prio_map.erase(it);
-        } else {
-          ++it;
-        }
+  /**
+   * Publishes a modified copy of the receiver list of `Signal`
+   */
+  template <typename Signal, typename Modify>
+  void update(Modify&& modify) {
+    const detail::receiver_list<Signal>* old;
+
+    {
+      std::lock_guard<std::mutex> guard(g_signal_update_lock);
+
+      auto& slot = detail::signal_slot<Signal>::receivers;
+      old = slot.load();
+
+      auto list = make_unique<detail::receiver_list<Signal>>();
+      if (old != nullptr) {
+        list->receivers = old->receivers;
       }
-    } catch (...) {
+      modify(list->receivers);
+
+      slot.store(list.release());
     }
+
+    // Not under the lock, receivers in other threads may attach or detach
+    retire(old);
   }
+
+  /**
+   * Waits until no emit can still be reading `list` (or previously retired
+   * lists) and frees them.
+   *
+   * Called from within an emit, the lists are kept until a later call outside
+   * of any emit because the calling emit may still be using them.
+   */
+  static void retire(const detail::receiver_list_base* list);
 };
 
 POLYBAR_NS_END
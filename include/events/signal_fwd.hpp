@@ -24,6 +24,7 @@ namespace signals {
     struct command;
     struct hook;
     struct action;
+    struct stats;
   } // namespace ipc
   namespace ui {
     struct changed;
@@ -1,10 +1,5 @@
 #pragma once
 
-#include <map>
-#include <typeindex>
-#include <typeinfo>
-#include <unordered_map>
-
 #include "common.hpp"
 
 POLYBAR_NS
@@ -12,7 +7,6 @@ POLYBAR_NS
 class signal_receiver_interface {
  public:
   using prio = int;
-  using prio_map = std::multimap<prio, signal_receiver_interface*>;
   virtual ~signal_receiver_interface() {}
   virtual prio priority() const = 0;
   template <typename Signal>
@@ -47,6 +41,4 @@ class signal_receiver : public signal_receiver_interface,
   }
 };
 
-using signal_receivers_t = std::unordered_map<std::type_index, signal_receiver_interface::prio_map>;
-
 POLYBAR_NS_END
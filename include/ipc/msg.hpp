@@ -79,6 +79,13 @@ namespace ipc {
        * Message type for ipc module actions
        */
       ACTION = 2,
+      /**
+       * Message type for performance statistics requests
+       *
+       * The payload is the requested format ("text" or "json", empty means
+       * "text"). A successful response carries the report as its payload.
+       */
+      STATS = 3,
     };
   }
 }  // namespace ipc
@@ -4,6 +4,7 @@
 #include "modules/meta/inotify_module.hpp"
 #include "modules/meta/types.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
 
 POLYBAR_NS
 
@@ -25,10 +26,10 @@ namespace modules {
    public:
     struct brightness_handle {
       void filepath(const string& path);
-      float read() const;
+      float read();
 
      private:
-      string m_path;
+      unique_ptr<proc_file> m_file;
     };
 
     string get_output();
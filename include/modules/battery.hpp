@@ -1,13 +1,15 @@
 #pragma once
 
 #include "common.hpp"
-#include "modules/meta/inotify_module.hpp"
+#include "modules/meta/event_module.hpp"
 #include "modules/meta/types.hpp"
+#include "utils/file.hpp"
+#include "utils/wakeup_fd.hpp"
 
 POLYBAR_NS
 
 namespace modules {
-  class battery_module : public inotify_module<battery_module> {
+  class battery_module : public event_module<battery_module> {
    public:
     enum class state {
       NONE = 0,
@@ -17,53 +19,39 @@ namespace modules {
       FULL,
     };
 
-    enum class value {
-      NONE = 0,
-      ADAPTER,
-      CAPACITY,
-      CAPACITY_MAX,
-      VOLTAGE,
-      RATE,
+    /**
+     * @brief Values of a single update, every file is read once
+     */
+    struct snapshot {
+      bool charging{false};
+      unsigned long capacity_now{0};
+      unsigned long capacity_full{0};
+      long long rate{0};
+      unsigned long voltage{0};
     };
 
-    template <typename ReturnType>
-    struct value_reader {
-      using return_type = ReturnType;
-
-      explicit value_reader() = default;
-      explicit value_reader(function<ReturnType()>&& fn) : m_fn(forward<decltype(fn)>(fn)) {}
-
-      ReturnType read() const {
-        return m_fn();
-      }
-
-     private:
-      const function<ReturnType()> m_fn;
-    };
-
-    using state_reader = mutex_wrapper<value_reader<bool /* is_charging */>>;
-    using capacity_reader = mutex_wrapper<value_reader<int /* percentage */>>;
-    using rate_reader = mutex_wrapper<value_reader<unsigned long /* seconds */>>;
-    using consumption_reader = mutex_wrapper<value_reader<string /* watts */>>;
-
    public:
     explicit battery_module(const bar_settings&, string, const config&);
 
     void start() override;
-    void teardown();
     void idle();
-    bool on_event(const inotify_event& event);
+    void wakeup();
+    bool has_event();
+    bool update();
     string get_format() const;
     bool build(builder* builder, const string& tag) const;
 
     static constexpr auto TYPE = BATTERY_TYPE;
 
    protected:
-    state current_state();
-    int current_percentage();
+    void read_snapshot();
+    bool open_uevent_socket();
+    bool is_power_supply_event(const char* msg, size_t size) const;
+    state current_state() const;
+    int current_percentage() const;
     int clamp_percentage(int percentage, state state) const;
-    string current_time();
-    string current_consumption();
+    string current_time() const;
+    string current_consumption() const;
     void subthread();
 
    private:
@@ -83,12 +71,24 @@ namespace modules {
     static constexpr const char* TAG_LABEL_FULL{"<label-full>"};
     static constexpr const char* TAG_LABEL_LOW{"<label-low>"};
 
-    static const size_t SKIP_N_UNCHANGED{3_z};
-
-    unique_ptr<state_reader> m_state_reader;
-    unique_ptr<capacity_reader> m_capacity_reader;
-    unique_ptr<rate_reader> m_rate_reader;
-    unique_ptr<consumption_reader> m_consumption_reader;
+    /**
+     * Opened once, every update rereads them into m_snapshot
+     */
+    unique_ptr<proc_file> m_state_file;
+    unique_ptr<proc_file> m_capnow_file;
+    unique_ptr<proc_file> m_capfull_file;
+    unique_ptr<proc_file> m_rate_file;
+    unique_ptr<proc_file> m_voltage_file;
+    snapshot m_snapshot{};
+
+    /**
+     * Kernel uevents for the power supplies and the eventfd used to stop
+     * waiting for them
+     */
+    unique_ptr<file_descriptor> m_uevent_fd;
+    wakeup_fd m_wakeup;
+    string m_battery_name;
+    string m_adapter_name;
 
     label_t m_label_charging;
     label_t m_label_discharging;
@@ -106,6 +106,7 @@ namespace modules {
     string m_fcapfull;
     string m_frate;
     string m_fvoltage;
+    bool m_state_from_status{true};
 
     state m_state{state::DISCHARGING};
     int m_percentage{0};
@@ -113,10 +114,13 @@ namespace modules {
     int m_fullat{100};
     int m_lowat{10};
     string m_timeformat;
-    size_t m_unchanged{SKIP_N_UNCHANGED};
     chrono::duration<double> m_interval{};
     chrono::steady_clock::time_point m_lastpoll;
-    thread m_subthread;
+
+    /**
+     * Set by idle() and consumed by has_event(), both run on the module thread
+     */
+    bool m_changed{false};
   };
 } // namespace modules
 
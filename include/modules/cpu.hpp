@@ -1,23 +1,24 @@
 #pragma once
 
+#include "drawtypes/ramp.hpp"
 #include "modules/meta/timer_module.hpp"
 #include "modules/meta/types.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
 
 POLYBAR_NS
 
 namespace modules {
   enum class cpu_state { NORMAL = 0, WARN };
-  struct cpu_time {
-    unsigned long long user;
-    unsigned long long nice;
-    unsigned long long system;
-    unsigned long long idle;
-    unsigned long long steal;
-    unsigned long long total;
-  };
 
-  using cpu_time_t = unique_ptr<cpu_time>;
+  /**
+   * Cumulative times of all cores, one array per field so that the loads of
+   * all cores can be computed in a single pass
+   */
+  struct cpu_samples {
+    vector<unsigned long long> idle;
+    vector<unsigned long long> total;
+  };
 
   class cpu_module : public timer_module<cpu_module> {
    public:
@@ -31,7 +32,6 @@ namespace modules {
 
    protected:
     bool read_values();
-    float get_load(size_t core) const;
 
    private:
     static constexpr auto TAG_LABEL = "<label>";
@@ -46,10 +46,12 @@ namespace modules {
     progressbar_t m_barload;
     ramp_t m_rampload;
     ramp_t m_rampload_core;
+    ramp_table m_rampload_core_table;
     spacing_val m_ramp_padding{spacing_type::SPACE, 1U};
 
-    vector<cpu_time_t> m_cputimes;
-    vector<cpu_time_t> m_cputimes_prev;
+    proc_file m_stat{PATH_CPU_INFO};
+    cpu_samples m_samples;
+    cpu_samples m_samples_prev;
 
     float m_totalwarn = 80;
     float m_total = 0;
@@ -1,13 +1,33 @@
 #pragma once
 
+#include <sys/statvfs.h>
+
+#include <condition_variable>
+
 #include "components/config.hpp"
 #include "modules/meta/timer_module.hpp"
 #include "modules/meta/types.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
+#include "utils/wakeup_fd.hpp"
 
 POLYBAR_NS
 
 namespace modules {
+  /**
+   * @brief Result of a statvfs call running on its own thread
+   *
+   * Shared with the thread, so that a call that never returns (e.g. on a hung
+   * NFS mount) can be abandoned.
+   */
+  struct fs_query {
+    std::mutex lock;
+    std::condition_variable cv;
+    bool done{false};
+    int error{0};
+    struct statvfs result {};
+  };
+
   /**
    * Filesystem structure
    */
@@ -15,6 +35,13 @@ namespace modules {
     string mountpoint;
     bool mounted = false;
 
+    /**
+     * statvfs call that has not finished yet and whether the values are from
+     * an earlier call because of it
+     */
+    shared_ptr<fs_query> query;
+    bool stale{false};
+
     string type;
     string fsname;
 
@@ -43,8 +70,16 @@ namespace modules {
     string get_output();
     bool build(builder* builder, const string& tag) const;
 
+    void sleep_until(chrono::steady_clock::time_point point);
+    void wakeup();
+
     static constexpr auto TYPE = FS_TYPE;
 
+   protected:
+    void read_mountinfo();
+    void start_query(fs_mount& mount);
+    void finish_query(fs_mount& mount, chrono::steady_clock::time_point deadline);
+
    private:
     static constexpr auto FORMAT_MOUNTED = "format-mounted";
     static constexpr auto FORMAT_WARN = "format-warn";
@@ -65,6 +100,15 @@ namespace modules {
 
     vector<string> m_mountpoints;
     vector<fs_mount_t> m_mounts;
+
+    /**
+     * The mount table is only parsed again after the kernel reported a change
+     * through POLLPRI
+     */
+    proc_file m_mountinfo{"/proc/self/mountinfo"};
+    bool m_mountinfo_changed{true};
+    wakeup_fd m_wakeup;
+
     bool m_fixed{false};
     bool m_remove_unmounted{false};
     spacing_val m_spacing{spacing_type::SPACE, 2U};
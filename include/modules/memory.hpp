@@ -3,6 +3,7 @@
 #include "modules/meta/timer_module.hpp"
 #include "modules/meta/types.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
 
 POLYBAR_NS
 
@@ -32,6 +33,7 @@ namespace modules {
     static constexpr const char* TAG_RAMP_SWAP_FREE{"<ramp-swap-free>"};
     static constexpr const char* FORMAT_WARN{"format-warn"};
 
+    proc_file m_meminfo{PATH_MEMORY_INFO};
     label_t m_label;
     label_t m_labelwarn;
     progressbar_t m_bar_memused;
@@ -4,6 +4,7 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <map>
 #include <mutex>
 
@@ -13,6 +14,8 @@
 #include "errors.hpp"
 #include "utils/concurrency.hpp"
 #include "utils/inotify.hpp"
+#include "utils/perf.hpp"
+#include "utils/trace.hpp"
 #include "utils/string.hpp"
 POLYBAR_NS
 
@@ -100,6 +103,37 @@ namespace modules {
 
   // }}}
 
+  // class definition : module_stats {{{
+
+  /**
+   * Performance counters of a single module
+   */
+  struct module_stats {
+    /**
+     * Duration of update() calls made by the module thread
+     */
+    perf_util::histogram update;
+
+    /**
+     * Duration of output rebuilds (get_output())
+     */
+    perf_util::histogram output;
+
+    atomic<size_t> broadcasts{0};
+
+    /**
+     * Broadcasts that did not reach the controller because the output of the
+     * module did not change
+     */
+    atomic<size_t> suppressed{0};
+
+    /**
+     * Size of the most recent output in bytes
+     */
+    atomic<size_t> output_size{0};
+  };
+
+  // }}}
   // class definition : module_interface {{{
 
   struct module_interface {
@@ -109,13 +143,13 @@ namespace modules {
     /**
      * The type users have to specify in the module section `type` key
      */
-    virtual string type() const = 0;
+    virtual const string& type() const = 0;
 
     /**
      * Module name w/o 'module/' prefix
      */
-    virtual string name_raw() const = 0;
-    virtual string name() const = 0;
+    virtual const string& name_raw() const = 0;
+    virtual const string& name() const = 0;
     virtual bool running() const = 0;
     virtual bool visible() const = 0;
 
@@ -134,8 +168,22 @@ namespace modules {
     virtual void stop() = 0;
     virtual void halt(string error_message) = 0;
     virtual string contents() = 0;
+    virtual const module_stats& stats() const = 0;
   };
 
+  using module_t = shared_ptr<module_interface>;
+
+  /**
+   * Puts a new instance of a module in place of the old one in all given lists
+   * and stops the old one
+   *
+   * The new module has to be started already. It replaces the old one before
+   * that is stopped, so the check_state event emitted by stop() still sees a
+   * running module when the reloaded module is the only one. If module is
+   * empty, the old one is only removed.
+   */
+  void replace_module(const module_t& old, const module_t& module, const vector<vector<module_t>*>& lists);
+
   // }}}
   // class definition : module {{{
 
@@ -149,10 +197,10 @@ namespace modules {
     static constexpr auto EVENT_MODULE_SHOW = "module_show";
     static constexpr auto EVENT_MODULE_HIDE = "module_hide";
 
-    string type() const override;
+    const string& type() const override;
 
-    string name_raw() const override;
-    string name() const override;
+    const string& name_raw() const override;
+    const string& name() const override;
     bool running() const override;
 
     bool visible() const override;
@@ -163,6 +211,7 @@ namespace modules {
     void halt(string error_message) override;
     void teardown();
     string contents() override;
+    const module_stats& stats() const override;
 
     bool input(const string& action, const string& data) final override;
 
@@ -188,6 +237,7 @@ namespace modules {
     void wakeup();
     string get_format() const;
     string get_output();
+    bool rebuild_cache();
 
     virtual void set_visible(bool value);
 
@@ -208,19 +258,34 @@ namespace modules {
     mutex m_sleeplock;
     std::condition_variable m_sleephandler;
 
+    const string m_type;
     const string m_name;
     const string m_name_raw;
     unique_ptr<builder> m_builder;
     unique_ptr<module_formatter> m_formatter;
+
+    /**
+     * Joined by join(), after stop() released its locks. Threads that call
+     * broadcast() must be added here instead of being joined in teardown(),
+     * which runs with m_buildlock held.
+     */
     vector<thread> m_threads;
     thread m_mainthread;
 
     bool m_handle_events{true};
 
+    module_stats m_stats;
+
    private:
     atomic<bool> m_enabled{false};
     atomic<bool> m_visible{true};
-    atomic<bool> m_changed{true};
+
+    /**
+     * Protects m_cache.
+     *
+     * The cache is rebuilt by whichever thread broadcasts and read by the main thread.
+     */
+    mutex m_cachelock;
     string m_cache;
   };
 
@@ -21,6 +21,7 @@ namespace modules {
       , m_log(logger::make())
       , m_conf(conf)
       , m_router(make_unique<action_router>())
+      , m_type(Impl::TYPE)
       , m_name("module/" + name)
       , m_name_raw(name)
       , m_builder(make_unique<builder>(bar))
@@ -46,18 +47,18 @@ namespace modules {
   }
 
   template <typename Impl>
-  string module<Impl>::name() const {
+  const string& module<Impl>::name() const {
     return m_name;
   }
 
   template <typename Impl>
-  string module<Impl>::name_raw() const {
+  const string& module<Impl>::name_raw() const {
     return m_name_raw;
   }
 
   template <typename Impl>
-  string module<Impl>::type() const {
-    return string(Impl::TYPE);
+  const string& module<Impl>::type() const {
+    return m_type;
   }
 
   template <typename Impl>
@@ -119,20 +120,15 @@ namespace modules {
 
   template <typename Impl>
   string module<Impl>::contents() {
-    if (m_changed.exchange(false)) {
-      m_log.info("%s: Rebuilding cache", name());
-      m_cache = CAST_MOD(Impl)->get_output();
-      // Make sure builder is really empty
-      m_builder->flush();
-      if (!m_cache.empty()) {
-        // Add a reset tag after the module
-        m_builder->control(tags::controltag::R);
-        m_cache += m_builder->flush();
-      }
-    }
+    std::lock_guard<std::mutex> guard(m_cachelock);
     return m_cache;
   }
 
+  template <typename Impl>
+  const module_stats& module<Impl>::stats() const {
+    return m_stats;
+  }
+
   template <typename Impl>
   bool module<Impl>::input(const string& name, const string& data) {
     if (!m_router->has_action(name)) {
@@ -150,9 +146,32 @@ namespace modules {
   // }}}
   // module<Impl> protected {{{
 
+  /**
+   * Rebuilds the cached output and notifies the controller if it changed.
+   *
+   * The output is built in the calling thread (usually the module thread) so
+   * that updates which produce byte-identical output never reach the main
+   * thread.
+   */
   template <typename Impl>
   void module<Impl>::broadcast() {
-    m_changed = true;
+    m_stats.broadcasts++;
+
+    /*
+     * Hidden modules don't contribute to the bar, their cache is rebuilt once
+     * they become visible again.
+     */
+    if (!visible()) {
+      return;
+    }
+
+    if (!rebuild_cache()) {
+      m_stats.suppressed++;
+      m_log.trace_x("%s: Output unchanged, suppressing broadcast", name());
+      return;
+    }
+
+    trace_util::instant("notify_change", name());
     m_sig.emit(signals::eventqueue::notify_change{});
   }
 
@@ -284,11 +303,57 @@ namespace modules {
     return format->decorate(&*m_builder, m_builder->flush());
   }
 
+  /**
+   * Rebuilds the module output and stores it in the cache.
+   *
+   * @returns true iff the new output differs from the cached one
+   */
+  template <typename Impl>
+  bool module<Impl>::rebuild_cache() {
+    std::lock_guard<std::mutex> guard(m_cachelock);
+
+    m_log.info("%s: Rebuilding cache", name());
+
+    string output;
+    try {
+      perf_util::scoped_timer timer(m_stats.output);
+      trace_util::span span("output", name());
+      output = CAST_MOD(Impl)->get_output();
+      // Make sure builder is really empty
+      m_builder->flush();
+      if (!output.empty()) {
+        // Add a reset tag after the module
+        m_builder->control(tags::controltag::R);
+        output += m_builder->flush();
+      }
+    } catch (const exception& err) {
+      m_log.err("%s: Failed to get contents (err: %s)", name(), err.what());
+      output.clear();
+    }
+
+    m_stats.output_size = output.size();
+
+    if (output == m_cache) {
+      return false;
+    }
+
+    m_cache = move(output);
+    return true;
+  }
+
   template <typename Impl>
   void module<Impl>::set_visible(bool value) {
     m_log.notice("%s: Visibility changed (state=%s)", m_name, value ? "shown" : "hidden");
     m_visible = value;
-    broadcast();
+
+    /*
+     * The visibility itself changes what the bar displays, so the controller
+     * is always notified, even if the module output is the same.
+     */
+    if (value) {
+      rebuild_cache();
+    }
+    m_sig.emit(signals::eventqueue::notify_change{});
   }
 
   template <typename Impl>
@@ -21,13 +21,24 @@ namespace modules {
       try {
         // warm up module output before entering the loop
         std::unique_lock<std::mutex> guard(this->m_updatelock);
-        CAST_MOD(Impl)->update();
+        {
+          perf_util::scoped_timer timer(this->m_stats.update);
+          trace_util::span span("update", this->name());
+          CAST_MOD(Impl)->update();
+        }
         CAST_MOD(Impl)->broadcast();
         guard.unlock();
 
         const auto check = [&]() -> bool {
           std::lock_guard<std::mutex> guard(this->m_updatelock);
-          return CAST_MOD(Impl)->has_event() && CAST_MOD(Impl)->update();
+          if (!CAST_MOD(Impl)->has_event()) {
+            return false;
+          }
+
+          perf_util::scoped_timer timer(this->m_stats.update);
+
+          trace_util::span span("update", this->name());
+          return CAST_MOD(Impl)->update();
         };
 
         while (this->running()) {
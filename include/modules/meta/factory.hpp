@@ -8,8 +8,6 @@
 POLYBAR_NS
 
 namespace modules {
-  using module_t = shared_ptr<module_interface>;
-
   /**
    * Creates a new module instance.
    *
@@ -20,6 +18,15 @@ namespace modules {
    * @param config A @ref config instance
    */
   module_t make_module(string&& type, const bar_settings& bar, string module_name, const logger& log, const config& config);
+
+  /**
+   * Whether modules of the given type have to be created and started on the
+   * main thread.
+   *
+   * This is the case for all modules that talk to the X server, the X
+   * connection must not be used from multiple threads concurrently.
+   */
+  bool needs_main_thread(const string& type);
 } // namespace modules
 
 POLYBAR_NS_END
@@ -22,7 +22,11 @@ namespace modules {
       try {
         // Warm up module output before entering the loop
         std::unique_lock<std::mutex> guard(this->m_updatelock);
-        CAST_MOD(Impl)->on_event({});
+        {
+          perf_util::scoped_timer timer(this->m_stats.update);
+          trace_util::span span("update", this->name());
+          CAST_MOD(Impl)->on_event({});
+        }
         CAST_MOD(Impl)->broadcast();
         guard.unlock();
 
@@ -66,7 +70,14 @@ namespace modules {
 
           if (w.poll(1000 / watches.size())) {
             auto event = w.get_event();
-            if (CAST_MOD(Impl)->on_event(event)) {
+            bool changed;
+            {
+              perf_util::scoped_timer timer(this->m_stats.update);
+              trace_util::span span("update", this->name());
+              changed = CAST_MOD(Impl)->on_event(event);
+            }
+
+            if (changed) {
               CAST_MOD(Impl)->broadcast();
             }
             CAST_MOD(Impl)->idle();
@@ -12,7 +12,11 @@ namespace modules {
 
     void start() override {
       this->module<Impl>::start();
-      CAST_MOD(Impl)->update();
+      {
+        perf_util::scoped_timer timer(this->m_stats.update);
+        trace_util::span span("update", this->name());
+        CAST_MOD(Impl)->update();
+      }
       CAST_MOD(Impl)->broadcast();
     }
 
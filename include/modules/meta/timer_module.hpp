@@ -37,6 +37,8 @@ namespace modules {
 
       const auto check = [&]() -> bool {
         std::unique_lock<std::mutex> guard(this->m_updatelock);
+        perf_util::scoped_timer timer(this->m_stats.update);
+        trace_util::span span("update", this->name());
         return CAST_MOD(Impl)->update();
       };
 
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <poll.h>
+
 #include "adapters/net.hpp"
 #include "components/config.hpp"
 #include "modules/meta/timer_module.hpp"
 #include "modules/meta/types.hpp"
+#include "utils/wakeup_fd.hpp"
 
 POLYBAR_NS
 
@@ -19,10 +22,14 @@ namespace modules {
     string get_format() const;
     bool build(builder* builder, const string& tag) const;
 
+    void sleep_until(chrono::steady_clock::time_point point);
+    void wakeup();
+
     static constexpr auto TYPE = NETWORK_TYPE;
 
    protected:
     void subthread_routine();
+    net::network* network() const;
 
    private:
     static constexpr auto FORMAT_CONNECTED = "format-connected";
@@ -46,6 +53,14 @@ namespace modules {
     atomic<bool> m_connected{false};
     atomic<bool> m_packetloss{false};
 
+    /**
+     * Held while waiting on the interface sockets, so that teardown() does not
+     * close them underneath
+     */
+    mutex m_polllock;
+    wakeup_fd m_wakeup;
+    vector<struct pollfd> m_pollfds;
+
     int m_signal{0};
     int m_quality{0};
     int m_counter{-1};  // -1 to ignore the first run
@@ -33,7 +33,7 @@ namespace modules {
     static constexpr auto TAG_LABEL_FAIL = "<label-fail>";
     static constexpr auto FORMAT_FAIL = "format-fail";
 
-    const bool m_tail;
+    const script_runner::mode m_mode;
     const script_runner::interval m_interval_success{0};
     const script_runner::interval m_interval_fail{0};
     const script_runner::interval m_interval_if{0};
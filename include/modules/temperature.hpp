@@ -5,6 +5,7 @@
 #include "modules/meta/timer_module.hpp"
 #include "modules/meta/types.hpp"
 #include "settings.hpp"
+#include "utils/file.hpp"
 
 POLYBAR_NS
 
@@ -31,6 +32,7 @@ namespace modules {
     ramp_t m_ramp;
 
     string m_path;
+    unique_ptr<proc_file> m_file;
     string m_zone_type;
     int m_zone = 0;
     // Base temperature used for where to start the ramp
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <map>
 
 #include "common.hpp"
@@ -113,6 +114,22 @@ namespace tags {
     void set_start(action_t id, double x);
     void set_end(action_t id, double x);
 
+    void invalidate_index();
+    void build_index() const;
+
+    /**
+     * Hit test index for the action blocks of a single mouse button.
+     *
+     * The bar is split into consecutive intervals at every block boundary
+     * (absolute positions). `top[i]` is the topmost action covering
+     * [bounds[i], bounds[i + 1]). Positions outside of [bounds.front(),
+     * bounds.back()) are not covered by any action.
+     */
+    struct interval_index {
+      std::vector<int> bounds;
+      std::vector<action_t> top;
+    };
+
     /**
      * Stores all currently known action blocks.
      *
@@ -129,6 +146,15 @@ namespace tags {
      */
     std::map<alignment, double> m_align_start{
         {alignment::NONE, 0}, {alignment::LEFT, 0}, {alignment::CENTER, 0}, {alignment::RIGHT, 0}};
+
+    /**
+     * Per-button hit test index.
+     *
+     * Lazily rebuilt on the first lookup after the action blocks or alignment
+     * positions changed, which is once per rendered frame.
+     */
+    mutable std::array<interval_index, static_cast<size_t>(mousebtn::BTN_COUNT)> m_index;
+    mutable bool m_index_dirty{true};
   };
 
 } // namespace tags
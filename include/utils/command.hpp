@@ -76,7 +76,11 @@ class command<output_policy::IGNORED> {
 template <>
 class command<output_policy::REDIRECTED> : private command<output_policy::IGNORED> {
  public:
-  explicit command(const logger& logger, string cmd);
+  /**
+   * stderr goes into the output pipe as well unless `redirect_stderr` is
+   * false, it is discarded then
+   */
+  explicit command(const logger& logger, string cmd, bool redirect_stderr = true);
   command(const command&) = delete;
   ~command();
 
@@ -100,6 +104,7 @@ class command<output_policy::REDIRECTED> : private command<output_policy::IGNORE
  protected:
   int m_stdout[2]{0, 0};
   int m_stdin[2]{0, 0};
+  bool m_redirect_stderr;
 
   unique_ptr<fd_stream<std::istream>> m_stdout_reader{nullptr};
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <mutex>
 #include <thread>
 
@@ -36,6 +37,19 @@ class mutex_wrapper : public T {
 
 namespace concurrency_util {
   size_t thread_id(const thread::id id);
-}
+
+  /**
+   * Calls `fn(i)` for every i in [0, count) on a pool of worker threads and
+   * waits until all calls have returned.
+   *
+   * The calling thread takes part in the work, so no thread is spawned for a
+   * single item.
+   *
+   * @param workers Upper bound for the number of threads, 0 means one per core
+   * @throws The first exception thrown by any call to `fn`, after all calls
+   *         have finished
+   */
+  void parallel_for(size_t count, const std::function<void(size_t)>& fn, size_t workers = 0);
+}  // namespace concurrency_util
 
 POLYBAR_NS_END
@@ -3,6 +3,7 @@
 #include <streambuf>
 
 #include "common.hpp"
+#include "utils/mixins.hpp"
 
 POLYBAR_NS
 
@@ -80,6 +81,82 @@ class fd_stream : public StreamType {
   fd_streambuf m_buf;
 };
 
+/**
+ * Read-only view of the whole contents of a file
+ *
+ * Regular files are mapped into memory, everything else (e.g. pipes or empty
+ * files) is read into a buffer.
+ */
+class mapped_file : public non_copyable_mixin, public non_movable_mixin {
+ public:
+  /**
+   * @throws system_error if the file cannot be opened
+   */
+  explicit mapped_file(const string& path);
+  ~mapped_file();
+
+  const char* data() const;
+  size_t size() const;
+
+ private:
+  void* m_map{nullptr};
+  size_t m_size{0};
+  string m_buffer;
+};
+
+/**
+ * Small file in /proc or /sys that is read repeatedly
+ *
+ * The file stays open and is read from the start with pread() into a buffer
+ * that is reused for every read, so reading it again does not allocate. The
+ * kernel generates the contents again for every read at offset 0.
+ */
+class proc_file : public non_copyable_mixin {
+ public:
+  /**
+   * The file is opened on the first read
+   */
+  explicit proc_file(string path);
+  ~proc_file();
+
+  /**
+   * Reads the current contents of the file
+   *
+   * If the file cannot be read, it is opened again on the next read (e.g.
+   * after a device was removed and added again).
+   *
+   * @returns false if the file could not be read, the contents are empty then
+   */
+  bool read();
+
+  /**
+   * Contents of the last read, always null-terminated
+   */
+  const char* data() const;
+  size_t size() const;
+
+  /**
+   * Reads the file and parses the decimal number at its start
+   *
+   * @returns `fallback` if the file could not be read or does not contain a
+   *          number
+   */
+  long long read_number(long long fallback = 0);
+
+  const string& path() const;
+
+  /**
+   * @returns The file descriptor of the last successful read or -1
+   */
+  int fd() const;
+
+ private:
+  string m_path;
+  int m_fd{-1};
+  vector<char> m_buffer;
+  size_t m_size{0};
+};
+
 namespace file_util {
   bool exists(const string& filename);
   bool is_file(const string& filename);
@@ -94,6 +171,16 @@ namespace file_util {
   vector<string> list_files(const string& dirname);
   string dirname(const string& path);
 
+  /**
+   * Parses the unsigned decimal number at `pos`, skipping leading blanks
+   *
+   * `pos` is moved behind the number. Stops at `end` or the first character
+   * that is not a digit.
+   *
+   * @returns false if there is no number at `pos`
+   */
+  bool parse_number(const char*& pos, const char* end, unsigned long long& value);
+
   template <typename... Args>
   decltype(auto) make_file_descriptor(Args&&... args) {
     return std::make_unique<file_descriptor>(forward<Args>(args)...);
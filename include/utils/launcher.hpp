@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "common.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+/**
+ * @brief Small helper process that runs shell commands for the bar
+ *
+ * The helper is forked at startup, before polybar starts its threads and
+ * loads any fonts. Commands are sent to it over a socketpair and it starts each
+ * of them in a new session and reaps them once they exit. How long it takes
+ * to start a command therefore does not depend on the size of the bar, and
+ * the bar never has to wait for or reap these children itself.
+ *
+ * The helper only keeps stdin, stdout and stderr of the files polybar had
+ * open. It exits once its end of the socketpair is closed, that is when the
+ * launcher is destroyed, which also reaps it, or when polybar exits.
+ */
+class launcher : public non_copyable_mixin {
+ public:
+  /**
+   * Forks the helper process.
+   *
+   * @throws system_error if the helper could not be started
+   */
+  explicit launcher();
+  ~launcher();
+
+  /**
+   * Has the helper run `cmd` using the shell, does not block.
+   *
+   * @returns false if the command could not be passed to the helper
+   */
+  bool run(const string& cmd);
+
+ private:
+  [[noreturn]] static void serve(int fd);
+
+  int m_fd{-1};
+  pid_t m_pid{-1};
+};
+
+POLYBAR_NS_END
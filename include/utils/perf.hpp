@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace perf_util {
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Lock-free histogram of durations with microsecond resolution.
+   *
+   * Values are sorted into log-linear buckets (four buckets per power of two),
+   * so percentiles are accurate to within 25%. Recording is wait-free and can
+   * happen concurrently with reading.
+   */
+  class histogram {
+   public:
+    void record(clock::duration duration);
+
+    uint64_t count() const;
+
+    /**
+     * Sum of all recorded values in microseconds
+     */
+    uint64_t total() const;
+
+    /**
+     * Largest recorded value in microseconds
+     */
+    uint64_t max() const;
+
+    /**
+     * Upper bound of the bucket containing the given percentile in
+     * microseconds, capped at max().
+     *
+     * @param p Percentile in the range [0, 100]
+     */
+    uint64_t percentile(double p) const;
+
+   private:
+    static constexpr size_t SUB_BUCKETS{4};
+    static constexpr size_t MAX_EXPONENT{40};
+    static constexpr size_t BUCKETS{SUB_BUCKETS + (MAX_EXPONENT - 2) * SUB_BUCKETS};
+
+    static size_t bucket(uint64_t value);
+    static uint64_t upper_bound(size_t bucket);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_total{0};
+    std::atomic<uint64_t> m_max{0};
+  };
+
+  /**
+   * Records the time between construction and destruction in a histogram
+   */
+  class scoped_timer {
+   public:
+    explicit scoped_timer(histogram& hist) : m_hist(hist), m_start(clock::now()) {}
+    ~scoped_timer() {
+      m_hist.record(clock::now() - m_start);
+    }
+
+    scoped_timer(const scoped_timer&) = delete;
+    scoped_timer& operator=(const scoped_timer&) = delete;
+
+   private:
+    histogram& m_hist;
+    clock::time_point m_start;
+  };
+
+  string text_header(const string& label);
+  string to_text(const string& label, const histogram& hist);
+  string to_json(const histogram& hist);
+  string json_escape(const string& value);
+} // namespace perf_util
+
+POLYBAR_NS_END
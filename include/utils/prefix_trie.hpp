@@ -0,0 +1,91 @@
+#pragma once
+
+#include <utility>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Maps string keys to values and finds keys that are a prefix of a given
+ * string.
+ *
+ * All nodes are stored in a single vector and reference their children by
+ * index. Lookups walk the trie once and do not allocate.
+ */
+template <typename T>
+class prefix_trie {
+ public:
+  prefix_trie() : m_nodes(1) {}
+
+  /**
+   * Adds the given key. An existing value for the same key is replaced.
+   */
+  void insert(const string& key, T value) {
+    size_t current = 0;
+
+    for (char c : key) {
+      size_t next = child(current, c);
+
+      if (next == 0) {
+        next = m_nodes.size();
+        m_nodes[current].children.emplace_back(c, next);
+        m_nodes.emplace_back();
+      }
+
+      current = next;
+    }
+
+    m_nodes[current].value = make_unique<T>(std::move(value));
+  }
+
+  /**
+   * Finds the longest key that is a prefix of `str`.
+   *
+   * @param[out] length Length of the matched key, only set if a key matched
+   * @returns A pointer to the value of the key or nullptr if no key matched
+   */
+  const T* match(const string& str, size_t& length) const {
+    const T* result = nullptr;
+    size_t current = 0;
+
+    for (size_t i = 0; i <= str.size(); i++) {
+      const auto& node = m_nodes[current];
+
+      if (node.value) {
+        result = node.value.get();
+        length = i;
+      }
+
+      if (i == str.size() || (current = child(current, str[i])) == 0) {
+        break;
+      }
+    }
+
+    return result;
+  }
+
+ private:
+  struct node {
+    vector<std::pair<char, size_t>> children;
+    unique_ptr<T> value;
+  };
+
+  /**
+   * @returns Index of the child of `index` for the character `c` or 0 if there
+   *          is none (the root is never a child).
+   */
+  size_t child(size_t index, char c) const {
+    for (const auto& entry : m_nodes[index].children) {
+      if (entry.first == c) {
+        return entry.second;
+      }
+    }
+
+    return 0;
+  }
+
+  vector<node> m_nodes;
+};
+
+POLYBAR_NS_END
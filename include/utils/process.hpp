@@ -7,16 +7,29 @@
 POLYBAR_NS
 
 namespace process_util {
-  bool in_parent_process(pid_t pid);
-  bool in_forked_process(pid_t pid);
-
-  void redirect_stdio_to_dev_null();
-
-  pid_t spawn_async(std::function<void()> const& lambda);
-  void fork_detached(std::function<void()> const& lambda);
+  /**
+   * @brief How a process started with spawn_sh is set up
+   */
+  struct spawn_options {
+    /**
+     * File descriptors the standard streams of the process are connected to,
+     * -1 connects the stream to /dev/null
+     */
+    int in{-1};
+    int out{-1};
+    int err{-1};
+
+    /**
+     * Start the process in a new session instead of only a new process group
+     */
+    bool new_session{false};
+  };
+
+  pid_t spawn_sh(const string& cmd, const vector<pair<string, string>>& env = {}, const spawn_options& options = {});
+  void spawn_detached(const string& cmd);
+  size_t reap_detached();
 
   void exec(char* cmd, char** args);
-  void exec_sh(const char* cmd, const vector<pair<string, string>>& env = {});
 
   int wait(pid_t pid);
 
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Bounded lock-free queue with any number of producers and a single consumer.
+ *
+ * Every slot carries a sequence number that tells producers and the consumer
+ * whether it is free or holds an item for the current lap around the buffer.
+ * Producers claim slots with a CAS on the head, the consumer owns the tail.
+ * Items are filled and consumed in place, so nothing is allocated after
+ * construction.
+ */
+template <typename T>
+class mpsc_ring_buffer {
+ public:
+  /**
+   * @param capacity Number of slots, rounded up to a power of two
+   */
+  explicit mpsc_ring_buffer(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+
+    m_mask = size - 1;
+    m_cells = make_unique<cell[]>(size);
+
+    for (size_t i = 0; i < size; i++) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpsc_ring_buffer(const mpsc_ring_buffer&) = delete;
+  mpsc_ring_buffer& operator=(const mpsc_ring_buffer&) = delete;
+
+  size_t capacity() const {
+    return m_mask + 1;
+  }
+
+  /**
+   * Claims a free slot and calls `fill(T&)` on it. Safe to call from any
+   * number of threads.
+   *
+   * @returns false without calling `fill` if the buffer is full
+   */
+  template <typename F>
+  bool try_push(F&& fill) {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+
+    while (true) {
+      cell& c = m_cells[pos & m_mask];
+      size_t seq = c.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          fill(c.data);
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Calls `consume(T&)` on the oldest item and releases its slot. Must only
+   * be called from a single thread.
+   *
+   * @returns false if the buffer is empty
+   */
+  template <typename F>
+  bool try_pop(F&& consume) {
+    cell& c = m_cells[m_tail & m_mask];
+    size_t seq = c.sequence.load(std::memory_order_acquire);
+
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(m_tail + 1) < 0) {
+      return false;
+    }
+
+    consume(c.data);
+    c.sequence.store(m_tail + m_mask + 1, std::memory_order_release);
+    m_tail++;
+    return true;
+  }
+
+ private:
+  struct cell {
+    std::atomic<size_t> sequence{0};
+    T data{};
+  };
+
+  unique_ptr<cell[]> m_cells;
+  size_t m_mask{0};
+
+  /**
+   * Head and tail are kept on separate cache lines so producers and the
+   * consumer don't invalidate each other's line on every operation.
+   */
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) size_t m_tail{0};
+};
+
+POLYBAR_NS_END
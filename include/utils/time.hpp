@@ -18,6 +18,24 @@ namespace time_util {
     auto finish = clock_t::now();
     return chrono::duration_cast<Duration>(finish - start).count();
   }
+
+  /**
+   * Measures the time passed since it was constructed.
+   *
+   * Used where the measured code doesn't fit into a single expression.
+   */
+  class stopwatch {
+   public:
+    stopwatch() : m_start(clock_t::now()) {}
+
+    template <typename Duration = chrono::milliseconds>
+    typename Duration::rep elapsed() const noexcept {
+      return chrono::duration_cast<Duration>(clock_t::now() - m_start).count();
+    }
+
+   private:
+    clock_t::time_point m_start;
+  };
 }
 
 POLYBAR_NS_END
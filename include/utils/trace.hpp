@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Opt-in recording of trace events in the Chrome trace-event JSON format.
+ *
+ * The output can be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Events are kept in a bounded in-memory buffer. Once it is full, the oldest
+ * events are overwritten. While recording is disabled, spans and instant
+ * events cost a single atomic load.
+ */
+namespace trace_util {
+  static constexpr size_t DEFAULT_CAPACITY{65536};
+
+  /**
+   * Starts recording, previously recorded events are discarded.
+   *
+   * @param path File the events are written to by dump()
+   */
+  void start(const string& path, size_t capacity = DEFAULT_CAPACITY);
+  void stop();
+  bool enabled();
+
+  /**
+   * Path given to the last call of start(), empty if never started
+   */
+  string path();
+
+  /**
+   * Writes the recorded events to the path given to start()
+   *
+   * Recording continues afterwards.
+   *
+   * @returns The path the events were written to
+   * @throws std::system_error if the file could not be written
+   */
+  string dump();
+
+  string to_json();
+
+  /**
+   * Records a zero-length event.
+   *
+   * @param detail Prepended to the event name, usually the module name
+   */
+  void instant(const char* name, const string& detail = {});
+
+  /**
+   * Records the time between construction and destruction as one event.
+   */
+  class span {
+   public:
+    explicit span(const char* name, const string& detail = {});
+    ~span();
+
+    span(const span&) = delete;
+    span& operator=(const span&) = delete;
+
+   private:
+    bool m_enabled;
+    int64_t m_start{0};
+    string m_name;
+  };
+} // namespace trace_util
+
+POLYBAR_NS_END
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.hpp"
+#include "utils/file.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+/**
+ * @brief eventfd that interrupts a thread waiting in poll()
+ *
+ * fd() is polled for POLLIN along with the descriptors the thread waits on.
+ * notify() makes it readable until drain() is called.
+ */
+class wakeup_fd : public non_copyable_mixin {
+ public:
+  /**
+   * @throws system_error if the eventfd could not be created
+   */
+  explicit wakeup_fd();
+
+  /**
+   * Makes fd() readable, safe to call from any thread
+   *
+   * @returns false if the eventfd could not be written to, errno is set then
+   */
+  bool notify();
+
+  /**
+   * Makes fd() stop being readable
+   */
+  void drain();
+
+  int fd() const;
+
+ private:
+  file_descriptor m_fd;
+};
+
+POLYBAR_NS_END
@@ -8,6 +8,8 @@
 
 #include <xcb/xcb_cursor.h>
 
+#include <map>
+
 #include "common.hpp"
 #include "utils/string.hpp"
 #include "x11/connection.hpp"
@@ -3,11 +3,15 @@
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <linux/ethtool.h>
+#include <linux/if.h>
 #include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <linux/sockios.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/ip_icmp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -17,7 +21,6 @@
 
 #include "common.hpp"
 #include "settings.hpp"
-#include "utils/command.hpp"
 #include "utils/file.hpp"
 #include "utils/string.hpp"
 
@@ -130,113 +133,521 @@ namespace net {
     return find_interface(NetType::ETHERNET);
   }
 
+  // class : connectivity_check {{{
+
+  connectivity_check::connectivity_check(string interface) : m_interface(move(interface)) {}
+
+  connectivity_check::connectivity_check(
+      string interface, string host, uint16_t port, std::chrono::milliseconds interval)
+      : m_interface(move(interface)), m_host(move(host)), m_port(port), m_interval(interval) {}
+
+  void connectivity_check::start() {
+    if (m_running) {
+      return;
+    }
+
+    if (m_fd == -1 && !open()) {
+      m_reachable = false;
+      return;
+    }
+
+    m_running = true;
+    m_sent = 0;
+    m_first_sequence = m_sequence + 1;
+    m_next_probe = clock::now();
+    send_probe();
+  }
+
+  bool connectivity_check::process() {
+    if (!m_running) {
+      return false;
+    }
+
+    if (receive_reply()) {
+      m_running = false;
+      m_reachable = true;
+      return true;
+    }
+
+    auto now = clock::now();
+    if (m_sent < PROBES && now >= m_next_probe) {
+      send_probe();
+    } else if (m_sent == PROBES && now >= m_timeout) {
+      m_running = false;
+      m_reachable = false;
+      return true;
+    }
+
+    return false;
+  }
+
+  bool connectivity_check::running() const {
+    return m_running;
+  }
+
+  bool connectivity_check::reachable() const {
+    return m_reachable;
+  }
+
+  int connectivity_check::fd() const {
+    return m_fd;
+  }
+
+  connectivity_check::clock::time_point connectivity_check::deadline() const {
+    if (!m_running) {
+      return clock::time_point::max();
+    }
+    return m_sent < PROBES ? m_next_probe : m_timeout;
+  }
+
+  bool connectivity_check::open() {
+    struct addrinfo hints {};
+    struct addrinfo* result;
+    hints.ai_family = AF_INET;
+
+    if (getaddrinfo(m_host.c_str(), nullptr, &hints, &result) != 0) {
+      return false;
+    }
+
+    struct sockaddr_in addr;
+    memcpy(&addr, result->ai_addr, sizeof(addr));
+    freeaddrinfo(result);
+
+    int fd = m_port == 0 ? socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_ICMP) : -1;
+    m_icmp = fd != -1;
+
+    if (!m_icmp) {
+      fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      addr.sin_port = htons(m_port == 0 ? 53 : m_port);
+    }
+
+    if (fd == -1) {
+      return false;
+    }
+    m_fd = fd;
+
+    /*
+     * Like `ping -I`, older kernels only allow this with CAP_NET_RAW, the
+     * probes are then sent through the default route
+     */
+    setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, m_interface.c_str(), m_interface.size());
+
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+      m_fd = -1;
+      return false;
+    }
+
+    return true;
+  }
+
+  void connectivity_check::send_probe() {
+    auto sequence = ++m_sequence;
+
+    if (m_icmp) {
+      // The kernel fills in the identifier and checksum
+      struct icmphdr header {};
+      header.type = ICMP_ECHO;
+      header.un.echo.sequence = htons(sequence);
+      send(m_fd, &header, sizeof(header), 0);
+    } else {
+      // Recursive query for the NS records of the root zone
+      const unsigned char query[] = {static_cast<unsigned char>(sequence >> 8),
+          static_cast<unsigned char>(sequence & 0xFF), 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 1};
+      send(m_fd, query, sizeof(query), 0);
+    }
+
+    // Failures to send (e.g. no route to the host) count as lost probes
+    m_sent++;
+    m_next_probe = clock::now() + m_interval;
+    m_timeout = clock::now() + 2 * m_interval;
+  }
+
+  /**
+   * @returns true if any reply to a probe of the running check was received
+   */
+  bool connectivity_check::receive_reply() {
+    bool received = false;
+    unsigned char buffer[512];
+
+    while (true) {
+      auto bytes = recv(m_fd, buffer, sizeof(buffer), 0);
+
+      if (bytes == -1) {
+        // An ICMP error for the DNS query also means that the host is reachable
+        received |= !m_icmp && errno == ECONNREFUSED;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        continue;
+      }
+
+      uint16_t sequence;
+      if (m_icmp && static_cast<size_t>(bytes) >= sizeof(struct icmphdr)) {
+        struct icmphdr header;
+        memcpy(&header, buffer, sizeof(header));
+        if (header.type != ICMP_ECHOREPLY) {
+          continue;
+        }
+        sequence = ntohs(header.un.echo.sequence);
+      } else if (!m_icmp && bytes >= 2) {
+        sequence = buffer[0] << 8 | buffer[1];
+      } else {
+        continue;
+      }
+
+      // Replies to probes of an earlier check are too late
+      received |= static_cast<uint16_t>(sequence - m_first_sequence) < m_sent;
+    }
+
+    return received;
+  }
+
+  // }}}
+  // rtnetlink messages {{{
+
+  namespace rtnl {
+    bool parse_events(const void* data, size_t size, const string& interface, unsigned int& ifindex,
+        bool& link_changed, bool& addresses_changed) {
+      bool changed = false;
+
+      auto len = static_cast<unsigned int>(size);
+      for (auto msg = static_cast<const struct nlmsghdr*>(data); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+        if (msg->nlmsg_type == RTM_NEWLINK || msg->nlmsg_type == RTM_DELLINK) {
+          auto info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(msg));
+          auto attr_len = IFLA_PAYLOAD(msg);
+
+          // Follow the interface if it was recreated with a different index
+          for (auto attr = IFLA_RTA(info); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+            if (attr->rta_type == IFLA_IFNAME && msg->nlmsg_type == RTM_NEWLINK &&
+                interface == static_cast<const char*>(RTA_DATA(attr))) {
+              if (static_cast<unsigned int>(info->ifi_index) != ifindex) {
+                ifindex = info->ifi_index;
+                addresses_changed = true;
+              }
+            }
+          }
+
+          if (static_cast<unsigned int>(info->ifi_index) == ifindex) {
+            link_changed = changed = true;
+          }
+        } else if (msg->nlmsg_type == RTM_NEWADDR || msg->nlmsg_type == RTM_DELADDR) {
+          auto info = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(msg));
+          if (info->ifa_index == ifindex) {
+            addresses_changed = changed = true;
+          }
+        }
+      }
+
+      return changed;
+    }
+
+    int parse_response(const void* data, size_t size, uint32_t sequence, const callback_t& callback) {
+      auto len = static_cast<unsigned int>(size);
+      for (auto msg = static_cast<const struct nlmsghdr*>(data); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+        // Left over from an earlier request that timed out
+        if (msg->nlmsg_seq != sequence) {
+          continue;
+        }
+
+        if (msg->nlmsg_type == NLMSG_DONE) {
+          return 0;
+        } else if (msg->nlmsg_type == NLMSG_ERROR) {
+          return -static_cast<const struct nlmsgerr*>(NLMSG_DATA(msg))->error;
+        }
+
+        callback(msg);
+
+        if (!(msg->nlmsg_flags & NLM_F_MULTI)) {
+          return 0;
+        }
+      }
+
+      return -1;
+    }
+
+    void parse_stats(const struct nlmsghdr* msg, link_activity& activity) {
+      if (msg->nlmsg_len < NLMSG_LENGTH(sizeof(struct if_stats_msg))) {
+        return;
+      }
+
+      auto len = msg->nlmsg_len - NLMSG_LENGTH(sizeof(struct if_stats_msg));
+      auto attr = reinterpret_cast<const struct rtattr*>(
+          static_cast<const char*>(NLMSG_DATA(msg)) + NLMSG_ALIGN(sizeof(struct if_stats_msg)));
+
+      for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFLA_STATS_LINK_64 && RTA_PAYLOAD(attr) >= sizeof(struct rtnl_link_stats64)) {
+          struct rtnl_link_stats64 stats;
+          memcpy(&stats, RTA_DATA(attr), sizeof(stats));
+          activity.transmitted += stats.tx_bytes;
+          activity.received += stats.rx_bytes;
+        }
+      }
+    }
+
+    void parse_link(const struct nlmsghdr* msg, unsigned char& operstate, string& mac) {
+      auto info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(msg));
+      auto len = IFLA_PAYLOAD(msg);
+
+      for (auto attr = IFLA_RTA(info); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFLA_OPERSTATE && RTA_PAYLOAD(attr) > 0) {
+          operstate = *static_cast<const unsigned char*>(RTA_DATA(attr));
+        } else if (attr->rta_type == IFLA_ADDRESS && RTA_PAYLOAD(attr) > 0) {
+          auto bytes = static_cast<const unsigned char*>(RTA_DATA(attr));
+          char buf[4];
+          mac.clear();
+          for (size_t i = 0; i < RTA_PAYLOAD(attr); i++) {
+            snprintf(buf, sizeof(buf), i == 0 ? "%02x" : ":%02x", bytes[i]);
+            mac += buf;
+          }
+        }
+      }
+    }
+
+    void parse_address(const struct nlmsghdr* msg, unsigned int ifindex, string& ip, string& ip6) {
+      auto info = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(msg));
+      if (info->ifa_index != ifindex) {
+        return;
+      }
+
+      const void* local = nullptr;
+      const void* address = nullptr;
+      size_t address_size = 0;
+      auto len = IFA_PAYLOAD(msg);
+      for (auto attr = IFA_RTA(info); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFA_LOCAL) {
+          local = RTA_DATA(attr);
+        } else if (attr->rta_type == IFA_ADDRESS) {
+          address = RTA_DATA(attr);
+          address_size = RTA_PAYLOAD(attr);
+        }
+      }
+
+      char buffer[INET6_ADDRSTRLEN];
+
+      if (info->ifa_family == AF_INET) {
+        // IFA_ADDRESS is the address of the other end on point-to-point links
+        const void* addr = local ? local : address;
+        if (addr && inet_ntop(AF_INET, addr, buffer, sizeof(buffer))) {
+          ip = buffer;
+        }
+      } else if (info->ifa_family == AF_INET6 && address && address_size >= sizeof(struct in6_addr)) {
+        struct in6_addr addr;
+        memcpy(&addr, address, sizeof(addr));
+
+        if (IN6_IS_ADDR_LINKLOCAL(&addr) || IN6_IS_ADDR_SITELOCAL(&addr)) {
+          return;
+        }
+        if ((addr.s6_addr[0] & 0xFE) == 0xFC) {
+          /* Skip Unique Local Addresses (fc00::/7) */
+          return;
+        }
+        if (inet_ntop(AF_INET6, &addr, buffer, sizeof(buffer))) {
+          ip6 = buffer;
+        }
+      }
+    }
+  }  // namespace rtnl
+
+  // }}}
   // class : network {{{
 
   /**
    * Construct network interface
    */
-  network::network(string interface) : m_log(logger::make()), m_interface(move(interface)) {
+  network::network(string interface)
+      : m_log(logger::make()), m_interface(move(interface)), m_connectivity(m_interface) {
     assert(is_interface_valid(m_interface));
+    m_ifindex = if_nametoindex(m_interface.c_str());
 
     m_socketfd = file_util::make_file_descriptor(socket(AF_INET, SOCK_DGRAM, 0));
     if (!*m_socketfd) {
       throw network_error("Failed to open socket");
     }
 
+    m_events_fd = file_util::make_file_descriptor(
+        socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE));
+    m_request_fd = file_util::make_file_descriptor(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE));
+    if (!*m_events_fd || !*m_request_fd) {
+      throw network_error("Failed to open netlink socket");
+    }
+
+    struct sockaddr_nl addr {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(*m_events_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+      throw network_error("Failed to subscribe to netlink notifications");
+    }
+
+    // Never wait forever for a response
+    struct timeval timeout {};
+    timeout.tv_sec = 1;
+    setsockopt(*m_request_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Large enough for any single message, dumps are split over multiple reads
+    m_buffer.resize(32768);
+
     check_tuntap_or_bridge();
   }
 
   /**
    * Query device driver for information
+   *
+   * Counters are requested on every call, the addresses and the link state
+   * only after a notification reported that they changed.
    */
   bool network::query(bool accumulate) {
-    m_status.previous = m_status.current;
-    m_status.current.transmitted = 0;
-    m_status.current.received = 0;
-    m_status.current.time = std::chrono::steady_clock::now();
-    m_status.ip = NO_IP;
-    m_status.ip6 = NO_IP;
+    process_events();
 
-    struct ifaddrs* ifaddr;
-    if (getifaddrs(&ifaddr) == -1 || ifaddr == nullptr) {
-      return false;
+    if (m_link_changed) {
+      m_link_changed = false;
+      if (!query_link()) {
+        m_link_changed = true;
+        return false;
+      }
     }
 
-    m_status.mac = string_util::trim(file_util::contents(NET_PATH + m_interface + "/address"), isspace);
-    if (m_status.mac == "") {
-      m_status.mac = NO_MAC;
+    if (m_addresses_changed) {
+      m_addresses_changed = false;
+      if (!query_addresses()) {
+        m_addresses_changed = true;
+        return false;
+      }
     }
 
-    for (auto ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-      if (ifa->ifa_addr == nullptr) {
-        continue;
-      }
+    return query_stats(accumulate);
+  }
+
+  bool network::process_events() {
+    bool changed = false;
 
-      if (m_interface.compare(0, m_interface.length(), ifa->ifa_name) != 0) {
-        if (!accumulate || (ifa->ifa_data == nullptr && ifa->ifa_addr->sa_family != AF_PACKET)) {
+    while (true) {
+      auto bytes = recv(*m_events_fd, m_buffer.data(), m_buffer.size(), MSG_DONTWAIT);
+
+      if (bytes == -1) {
+        if (errno == ENOBUFS) {
+          // Notifications were dropped, assume they concerned us
+          m_link_changed = m_addresses_changed = changed = true;
           continue;
         }
+        break;
       }
 
-      struct sockaddr_in6* sa6;
+      changed |=
+          rtnl::parse_events(m_buffer.data(), bytes, m_interface, m_ifindex, m_link_changed, m_addresses_changed);
+    }
 
-      switch (ifa->ifa_addr->sa_family) {
-        case AF_INET:
-          char ip_buffer[NI_MAXHOST];
-          getnameinfo(ifa->ifa_addr, sizeof(sockaddr_in), ip_buffer, NI_MAXHOST, nullptr, 0, NI_NUMERICHOST);
-          m_status.ip = string{ip_buffer};
-          break;
+    return changed;
+  }
 
-        case AF_INET6:
-          char ip6_buffer[INET6_ADDRSTRLEN];
-          sa6 = reinterpret_cast<decltype(sa6)>(ifa->ifa_addr);
-          if (IN6_IS_ADDR_LINKLOCAL(&sa6->sin6_addr)) {
-            continue;
-          }
-          if (IN6_IS_ADDR_SITELOCAL(&sa6->sin6_addr)) {
-            continue;
-          }
-          if ((((unsigned char*)sa6->sin6_addr.s6_addr)[0] & 0xFE) == 0xFC) {
-            /* Skip Unique Local Addresses (fc00::/7) */
-            continue;
-          }
-          if (inet_ntop(AF_INET6, &sa6->sin6_addr, ip6_buffer, INET6_ADDRSTRLEN) == 0) {
-            m_log.warn("inet_ntop() " + string(strerror(errno)));
-            continue;
-          }
-          m_status.ip6 = string{ip6_buffer};
-          break;
+  void network::events_fds(vector<struct pollfd>& fds) const {
+    fds.push_back({*m_events_fd, POLLIN, 0});
+  }
 
-        case AF_PACKET:
-          if (ifa->ifa_data == nullptr) {
-            continue;
-          }
-          struct rtnl_link_stats* link_state = reinterpret_cast<decltype(link_state)>(ifa->ifa_data);
-          if (link_state == nullptr) {
-            continue;
-          }
-          m_status.current.transmitted += link_state->tx_bytes;
-          m_status.current.received += link_state->rx_bytes;
-          break;
-      }
+  connectivity_check& network::connectivity() {
+    return m_connectivity;
+  }
+
+  /**
+   * Sends a rtnetlink request and calls `callback` for every message of the
+   * response
+   *
+   * @returns 0 on success or an errno value
+   */
+  int network::request(uint16_t type, bool dump, const void* payload, size_t size, const rtnl::callback_t& callback) {
+    struct {
+      struct nlmsghdr header;
+      char payload[64];
+    } req{};
+
+    assert(size <= sizeof(req.payload));
+    req.header.nlmsg_len = NLMSG_LENGTH(size);
+    req.header.nlmsg_type = type;
+    req.header.nlmsg_flags = NLM_F_REQUEST | (dump ? NLM_F_DUMP : 0);
+    req.header.nlmsg_seq = ++m_request_sequence;
+    memcpy(NLMSG_DATA(&req.header), payload, size);
+
+    if (send(*m_request_fd, &req, req.header.nlmsg_len, 0) == -1) {
+      return errno;
     }
 
-    freeifaddrs(ifaddr);
+    while (true) {
+      auto bytes = recv(*m_request_fd, m_buffer.data(), m_buffer.size(), 0);
+      if (bytes == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return errno;
+      }
 
-    return true;
+      int err = rtnl::parse_response(m_buffer.data(), bytes, m_request_sequence, callback);
+      if (err != -1) {
+        return err;
+      }
+    }
   }
 
   /**
-   * Run ping command to test internet connectivity
+   * Reads the byte counters of the interface (or of all interfaces)
    */
-  bool network::ping() const {
-    try {
-      auto exec = "ping -c 2 -W 2 -I " + m_interface + " " + string(CONNECTION_TEST_IP);
-      command<output_policy::IGNORED> ping(m_log, exec);
-      return ping.exec(true) == EXIT_SUCCESS;
-    } catch (const std::exception& err) {
+  bool network::query_stats(bool accumulate) {
+    m_status.previous = m_status.current;
+    m_status.current.transmitted = 0;
+    m_status.current.received = 0;
+    m_status.current.time = std::chrono::steady_clock::now();
+
+    struct if_stats_msg msg {};
+    msg.family = AF_UNSPEC;
+    msg.ifindex = accumulate ? 0 : m_ifindex;
+    msg.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    int err = request(RTM_GETSTATS, accumulate, &msg, sizeof(msg),
+        [&](const struct nlmsghdr* hdr) { rtnl::parse_stats(hdr, m_status.current); });
+
+    if (err == ENODEV) {
+      // The interface is gone, it will show up as disconnected
+      m_operstate = IF_OPER_NOTPRESENT;
+      m_status.current.transmitted = m_status.previous.transmitted;
+      m_status.current.received = m_status.previous.received;
+      return true;
+    } else if (err != 0) {
+      m_log.warn("Failed to query statistics of %s (%s)", m_interface, strerror(err));
       return false;
     }
+
+    return true;
+  }
+
+  /**
+   * Reads the state and hardware address of the interface
+   */
+  bool network::query_link() {
+    struct ifinfomsg msg {};
+    msg.ifi_family = AF_UNSPEC;
+    msg.ifi_index = m_ifindex;
+
+    m_status.mac = NO_MAC;
+    m_operstate = IF_OPER_NOTPRESENT;
+
+    int err = request(RTM_GETLINK, false, &msg, sizeof(msg),
+        [&](const struct nlmsghdr* hdr) { rtnl::parse_link(hdr, m_operstate, m_status.mac); });
+
+    return err == 0 || err == ENODEV;
+  }
+
+  /**
+   * Reads the ipv4 and ipv6 addresses of the interface
+   */
+  bool network::query_addresses() {
+    struct ifaddrmsg msg {};
+    msg.ifa_family = AF_UNSPEC;
+
+    m_status.ip = NO_IP;
+    m_status.ip6 = NO_IP;
+
+    int err = request(RTM_GETADDR, true, &msg, sizeof(msg),
+        [&](const struct nlmsghdr* hdr) { rtnl::parse_address(hdr, m_ifindex, m_status.ip, m_status.ip6); });
+
+    return err == 0;
   }
 
   /**
@@ -333,9 +744,8 @@ namespace net {
    * Test if the network interface is in a valid state
    */
   bool network::test_interface() const {
-    auto operstate = file_util::contents(NET_PATH + m_interface + "/operstate");
-    bool up = operstate.compare(0, 2, "up") == 0;
-    return m_unknown_up ? (up || operstate.compare(0, 7, "unknown") == 0) : up;
+    bool up = m_operstate == IF_OPER_UP;
+    return m_unknown_up ? (up || m_operstate == IF_OPER_UNKNOWN) : up;
   }
 
   /**
@@ -1,7 +1,5 @@
 #include "adapters/net.hpp"
 
-#include "utils/file.hpp"
-
 POLYBAR_NS
 
 namespace net {
@@ -16,14 +14,10 @@ namespace net {
       return false;
     }
 
-    auto socket_fd = file_util::make_file_descriptor(iw_sockets_open());
-    if (!*socket_fd) {
-      return false;
-    }
-
+    // The wireless extensions accept any socket, use the one of the adapter
     struct iwreq req {};
 
-    if (iw_get_ext(*socket_fd, m_interface.c_str(), SIOCGIWMODE, &req) == -1) {
+    if (iw_get_ext(*m_socketfd, m_interface.c_str(), SIOCGIWMODE, &req) == -1) {
       return false;
     }
 
@@ -32,8 +26,8 @@ namespace net {
       return false;
     }
 
-    query_essid(*socket_fd);
-    query_quality(*socket_fd);
+    query_essid(*m_socketfd);
+    query_quality(*m_socketfd);
 
     return true;
   }
@@ -91,18 +85,23 @@ namespace net {
    * Query for device driver quality values
    */
   void wireless_network::query_quality(const int& socket_fd) {
-    iwrange range{};
     iwstats stats{};
 
-    // Fill range
-    if (iw_get_range_info(socket_fd, m_interface.c_str(), &range) == -1) {
-      return;
+    // Fill range, it only changes with the driver or device
+    if (!m_range_valid) {
+      if (iw_get_range_info(socket_fd, m_interface.c_str(), &m_range) == -1) {
+        return;
+      }
+      m_range_valid = true;
     }
     // Fill stats
-    if (iw_get_stats(socket_fd, m_interface.c_str(), &stats, &range, 1) == -1) {
+    if (iw_get_stats(socket_fd, m_interface.c_str(), &stats, &m_range, 1) == -1) {
+      m_range_valid = false;
       return;
     }
 
+    const iwrange& range = m_range;
+
     // Check if the driver supplies the quality value
     if (stats.qual.updated & IW_QUAL_QUAL_INVALID) {
       return;
@@ -1,6 +1,7 @@
 #include <linux/nl80211.h>
 #include <netlink/genl/ctrl.h>
 #include <netlink/genl/genl.h>
+#include <poll.h>
 
 #include <algorithm>
 
@@ -12,6 +13,8 @@ POLYBAR_NS
 namespace net {
   // class : wireless_network {{{
 
+  wireless_network::wireless_network(string interface) : network(move(interface)) {}
+
   /**
    * Query the wireless device for information
    * about the current connection
@@ -21,48 +24,158 @@ namespace net {
       return false;
     }
 
-    struct nl_sock* sk = nl_socket_alloc();
-    if (sk == nullptr) {
+    bool opened = false;
+    if (!m_socket) {
+      if (!open_sockets()) {
+        return false;
+      }
+      opened = true;
+    }
+
+    // Usually the response to the last request was already read while the module slept
+    receive(m_socket.get());
+
+    if (!m_scan_pending && !request_scan()) {
+      m_socket.reset();
+      m_events.reset();
       return false;
     }
 
-    if (genl_connect(sk) < 0) {
+    // Don't start out without any results
+    if (opened) {
+      struct pollfd fds{nl_socket_get_fd(m_socket.get()), POLLIN, 0};
+      while (m_scan_pending && poll(&fds, 1, 1000) > 0) {
+        if (!receive(m_socket.get())) {
+          break;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool wireless_network::process_events() {
+    bool changed = network::process_events();
+
+    if (!m_socket) {
+      return changed;
+    }
+
+    if (!receive(m_events.get())) {
+      // Notifications may have been dropped
+      m_refresh = true;
+    }
+
+    bool pending = m_scan_pending;
+    receive(m_socket.get());
+
+    if (pending && !m_scan_pending && m_wake_on_scan) {
+      m_wake_on_scan = false;
+      changed = true;
+    }
+
+    if (m_refresh && !m_scan_pending && request_scan()) {
+      m_refresh = false;
+      m_wake_on_scan = true;
+    }
+
+    return changed;
+  }
+
+  void wireless_network::events_fds(vector<struct pollfd>& fds) const {
+    network::events_fds(fds);
+    if (m_socket) {
+      fds.push_back({nl_socket_get_fd(m_socket.get()), POLLIN, 0});
+      fds.push_back({nl_socket_get_fd(m_events.get()), POLLIN, 0});
+    }
+  }
+
+  /**
+   * Opens the request socket and the socket subscribed to the nl80211 scan
+   * and mlme notifications
+   */
+  bool wireless_network::open_sockets() {
+    socket_t socket{nl_socket_alloc(), nl_socket_free};
+    socket_t events{nl_socket_alloc(), nl_socket_free};
+
+    if (!socket || !events || genl_connect(socket.get()) < 0 || genl_connect(events.get()) < 0) {
       return false;
     }
 
-    int driver_id = genl_ctrl_resolve(sk, "nl80211");
-    if (driver_id < 0) {
-      nl_socket_free(sk);
+    int family = genl_ctrl_resolve(socket.get(), "nl80211");
+    if (family < 0) {
       return false;
     }
 
-    if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0) {
-      nl_socket_free(sk);
+    for (const char* group : {"scan", "mlme"}) {
+      int id = genl_ctrl_resolve_grp(socket.get(), "nl80211", group);
+      if (id < 0 || nl_socket_add_membership(events.get(), id) < 0) {
+        return false;
+      }
+    }
+
+    // Responses are read whenever they arrive, not right after sending the request
+    nl_socket_disable_seq_check(socket.get());
+    nl_socket_disable_seq_check(events.get());
+    nl_socket_disable_auto_ack(socket.get());
+
+    if (nl_socket_set_nonblocking(socket.get()) < 0 || nl_socket_set_nonblocking(events.get()) < 0) {
       return false;
     }
 
+    if (nl_socket_modify_cb(socket.get(), NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0 ||
+        nl_socket_modify_cb(socket.get(), NL_CB_FINISH, NL_CB_CUSTOM, finish_cb, this) != 0 ||
+        nl_socket_modify_cb(events.get(), NL_CB_VALID, NL_CB_CUSTOM, event_cb, this) != 0) {
+      return false;
+    }
+
+    m_socket = move(socket);
+    m_events = move(events);
+    m_family = family;
+    m_scan_pending = false;
+    return true;
+  }
+
+  /**
+   * Requests the scan results without waiting for them
+   */
+  bool wireless_network::request_scan() {
     struct nl_msg* msg = nlmsg_alloc();
     if (msg == nullptr) {
-      nl_socket_free(sk);
       return false;
     }
 
-    if ((genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, driver_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) == nullptr) ||
-        nla_put_u32(msg, NL80211_ATTR_IFINDEX, m_ifid) < 0) {
+    if ((genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, m_family, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) == nullptr) ||
+        nla_put_u32(msg, NL80211_ATTR_IFINDEX, m_ifindex) < 0) {
       nlmsg_free(msg);
-      nl_socket_free(sk);
       return false;
     }
 
-    // nl_send_sync always frees msg
-    if (nl_send_sync(sk, msg) < 0) {
-      nl_socket_free(sk);
-      return false;
-    }
+    m_scan_pending = nl_send_auto(m_socket.get(), msg) >= 0;
+    nlmsg_free(msg);
 
-    nl_socket_free(sk);
+    return m_scan_pending;
+  }
 
-    return true;
+  /**
+   * Reads everything that arrived on the socket without blocking
+   *
+   * @returns false if reading failed
+   */
+  bool wireless_network::receive(struct nl_sock* socket) {
+    while (true) {
+      int err = nl_recvmsgs_default(socket);
+
+      if (err == -NLE_AGAIN) {
+        return true;
+      } else if (err < 0) {
+        // The request failed, there is nothing more to wait for
+        if (socket == m_socket.get()) {
+          m_scan_pending = false;
+        }
+        return false;
+      }
+    }
   }
 
   /**
@@ -140,6 +253,47 @@ namespace net {
     return NL_SKIP;
   }
 
+  /**
+   * Callback for the end of the scan results
+   */
+  int wireless_network::finish_cb(struct nl_msg*, void* instance) {
+    static_cast<wireless_network*>(instance)->m_scan_pending = false;
+    return NL_STOP;
+  }
+
+  /**
+   * Callback for nl80211 notifications
+   */
+  int wireless_network::event_cb(struct nl_msg* msg, void* instance) {
+    auto wn = static_cast<wireless_network*>(instance);
+    auto gnlh = static_cast<genlmsghdr*>(nlmsg_data(nlmsg_hdr(msg)));
+    struct nlattr* tb[NL80211_ATTR_MAX + 1];
+
+    if (nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), nullptr) < 0) {
+      return NL_SKIP;
+    }
+
+    if (tb[NL80211_ATTR_IFINDEX] == nullptr || nla_get_u32(tb[NL80211_ATTR_IFINDEX]) != wn->m_ifindex) {
+      return NL_SKIP;
+    }
+
+    switch (gnlh->cmd) {
+      case NL80211_CMD_NEW_SCAN_RESULTS:
+      case NL80211_CMD_CONNECT:
+      case NL80211_CMD_ROAM:
+      case NL80211_CMD_DISCONNECT:
+      case NL80211_CMD_ASSOCIATE:
+      case NL80211_CMD_DISASSOCIATE:
+      case NL80211_CMD_DEAUTHENTICATE:
+        wn->m_refresh = true;
+        break;
+      default:
+        break;
+    }
+
+    return NL_SKIP;
+  }
+
   /**
    * Check for a connection to a AP
    */
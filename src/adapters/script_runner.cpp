@@ -1,5 +1,11 @@
 #include "adapters/script_runner.hpp"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include <cassert>
 #include <functional>
 
@@ -11,15 +17,90 @@
 
 POLYBAR_NS
 
-script_runner::script_runner(on_update on_update, const string& exec, const string& exec_if, bool tail,
-    interval interval_success, interval interval_fail, const vector<pair<string, string>>& env)
+/**
+ * Maximum number of bytes read from a script at once, so that a script that
+ * never stops writing cannot starve the module. Longer lines are cut off.
+ */
+static constexpr size_t READ_LIMIT = 64 * 1024;
+
+/**
+ * Writes `request` to `fd` without raising SIGPIPE if the reader exited
+ *
+ * @returns true if the whole request was written
+ */
+static bool write_request(int fd, const string& request) {
+  sigset_t mask;
+  sigset_t old_mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+
+  ssize_t written = write(fd, request.data(), request.size());
+
+  if (written == -1 && errno == EPIPE) {
+    // Discard the SIGPIPE that is now pending for this thread
+    timespec zero{0, 0};
+    sigtimedwait(&mask, nullptr, &zero);
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+  return written == static_cast<ssize_t>(request.size());
+}
+
+/**
+ * Appends what can be read from the non-blocking `fd` to `buffer`, at most
+ * READ_LIMIT bytes
+ *
+ * `buffer` may only hold the start of a line. Lines are cut off after
+ * READ_LIMIT bytes, so a script that never ends its line cannot grow the
+ * buffer without limit.
+ *
+ * @returns false once the output was closed
+ */
+static bool read_available(int fd, string& buffer) {
+  char chunk[4096];
+  size_t total = 0;
+  ssize_t bytes = -1;
+
+  while (total < READ_LIMIT && (bytes = read(fd, chunk, sizeof(chunk))) != 0) {
+    if (bytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    buffer.append(chunk, bytes);
+    total += bytes;
+  }
+
+  bool open = bytes != 0 && (bytes != -1 || errno == EAGAIN || errno == EWOULDBLOCK);
+
+  // Drops the rest of a line that was already cut off in an earlier call
+  auto first_end = std::min(buffer.find('\n'), buffer.size());
+  if (first_end > READ_LIMIT) {
+    buffer.erase(READ_LIMIT, first_end - READ_LIMIT);
+  }
+
+  auto last_end = buffer.rfind('\n');
+  auto partial = last_end == string::npos ? 0 : last_end + 1;
+  if (buffer.size() - partial > READ_LIMIT) {
+    buffer.resize(partial + READ_LIMIT);
+  }
+
+  return open;
+}
+
+script_runner::script_runner(on_update on_update, const string& exec, const string& exec_if, mode mode,
+    interval interval_success, interval interval_fail, interval timeout, const vector<pair<string, string>>& env)
     : m_log(logger::make())
     , m_on_update(on_update)
     , m_exec(exec)
     , m_exec_if(exec_if)
-    , m_tail(tail)
+    , m_mode(mode)
     , m_interval_success(interval_success)
     , m_interval_fail(interval_fail)
+    , m_timeout(timeout)
     , m_env(env) {}
 
 /**
@@ -38,10 +119,13 @@ bool script_runner::check_condition() const {
  * Process mutex wrapped script handler
  */
 script_runner::interval script_runner::process() {
-  if (m_tail) {
-    return run_tail();
-  } else {
-    return run();
+  switch (m_mode) {
+    case mode::TAIL:
+      return run_tail();
+    case mode::COPROCESS:
+      return run_coprocess();
+    default:
+      return run();
   }
 }
 
@@ -54,6 +138,10 @@ void script_runner::clear_output() {
 
 void script_runner::stop() {
   m_stopping = true;
+
+  if (!m_wakeup.notify()) {
+    m_log.err("script_runner: Failed to interrupt script (%s)", strerror(errno));
+  }
 }
 
 bool script_runner::is_stopping() const {
@@ -153,14 +241,40 @@ script_runner::interval script_runner::run_tail() {
 
   int fd = cmd.get_stdout(PIPE_READ);
   assert(fd != -1);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  // Becomes readable once the script exits, not available before Linux 5.3
+  int pidfd = -1;
+#ifdef SYS_pidfd_open
+  pidfd = syscall(SYS_pidfd_open, m_data.pid, 0);
+#endif
+  auto pidfd_guard = file_util::make_file_descriptor(pidfd);
+
+  string buffer;
+  bool exited = false;
+
+  while (!m_stopping && !exited) {
+    pollfd fds[]{
+        {m_wakeup.fd(), POLLIN, 0},
+        {fd, POLLIN, 0},
+        {pidfd, POLLIN, 0},
+    };
+
+    // Without a pidfd, check whether the script is still running every second
+    if (poll(fds, pidfd == -1 ? 2 : 3, pidfd == -1 ? 1000 : -1) == -1 && errno != EINTR) {
+      throw modules::module_error("Failed to poll script output (" + string(strerror(errno)) + ")");
+    }
 
-  while (!m_stopping && cmd.is_running() && !io_util::poll(fd, POLLHUP, 0)) {
-    if (cmd.wait_for_data(250)) {
-      auto changed = set_output(cmd.readline());
+    // Only written to when the runner is stopped
+    if (fds[0].revents & POLLIN) {
+      break;
+    }
 
-      if (changed) {
-        m_on_update(m_data);
-      }
+    exited = (fds[2].revents & POLLIN) || (pidfd == -1 && !cmd.is_running());
+
+    // Either way, read whatever the script wrote before exiting
+    if ((fds[1].revents & (POLLIN | POLLHUP | POLLERR)) || exited) {
+      exited = !read_tail(fd, buffer) || exited;
     }
   }
 
@@ -178,4 +292,141 @@ script_runner::interval script_runner::run_tail() {
   }
 }
 
+/**
+ * Reads the available output of a tail script and publishes the last
+ * complete line in it.
+ *
+ * A burst of lines results in a single update with the newest line.
+ *
+ * @returns false once the output was closed, the remaining partial line is
+ *          then published as well
+ */
+bool script_runner::read_tail(int fd, string& buffer) {
+  bool open = read_available(fd, buffer);
+
+  if (!open && !buffer.empty() && buffer.back() != '\n') {
+    buffer += '\n';
+  }
+
+  auto end = buffer.rfind('\n');
+  if (end != string::npos) {
+    auto start = end == 0 ? string::npos : buffer.rfind('\n', end - 1);
+    start = start == string::npos ? 0 : start + 1;
+
+    auto changed = set_output(buffer.substr(start, end - start));
+    buffer.erase(0, end + 1);
+
+    if (changed) {
+      m_on_update(m_data);
+    }
+  }
+
+  return open;
+}
+
+/**
+ * Requests one line from the script kept running in coprocess mode
+ *
+ * The request line is the counter. The script is started for the first
+ * request and again after it exited or did not respond within the timeout.
+ * Only the first line printed after a request is its reply, any further
+ * lines are dropped before the next request. Its stderr is discarded.
+ */
+script_runner::interval script_runner::run_coprocess() {
+  if (!m_coprocess) {
+    auto exec = string_util::replace_all(m_exec, "%counter%", to_string(m_data.counter + 1));
+    m_log.info("script_runner: Starting coprocess: \"%s\"", exec);
+    m_coprocess = make_unique<command<output_policy::REDIRECTED>>(m_log, exec, false);
+
+    try {
+      m_coprocess->exec(false, m_env);
+    } catch (const exception& err) {
+      m_log.err("script_runner: %s", err.what());
+      throw modules::module_error("Failed to execute command, stopping module...");
+    }
+
+    m_data.pid = m_coprocess->get_pid();
+
+    int fd = m_coprocess->get_stdout(PIPE_READ);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+
+  int fd = m_coprocess->get_stdout(PIPE_READ);
+  assert(fd != -1);
+
+  // Whatever the script printed since its last reply does not belong to this request
+  string reply;
+  bool open = read_available(fd, reply);
+  reply.clear();
+
+  bool changed = false;
+  bool responded = false;
+
+  // Counted even if the script already exited, so the restarted one sees the same numbers either way
+  auto request = to_string(++m_data.counter) + "\n";
+
+  if (open && write_request(m_coprocess->get_stdin(PIPE_WRITE), request)) {
+    auto deadline = std::chrono::steady_clock::now() + m_timeout;
+
+    while (!m_stopping && open && !responded) {
+      auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      if (remaining <= 0ms) {
+        m_log.warn("script_runner: Coprocess did not respond within %.1f s", m_timeout.count());
+        break;
+      }
+
+      pollfd fds[]{
+          {m_wakeup.fd(), POLLIN, 0},
+          {fd, POLLIN, 0},
+      };
+
+      if (poll(fds, 2, static_cast<int>(remaining.count()) + 1) == -1 && errno != EINTR) {
+        throw modules::module_error("Failed to poll script output (" + string(strerror(errno)) + ")");
+      }
+
+      // Only written to when the runner is stopped
+      if (fds[0].revents & POLLIN) {
+        break;
+      }
+
+      if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+        open = read_available(fd, reply);
+
+        auto end = reply.find('\n');
+        if (end != string::npos) {
+          changed = set_output(reply.substr(0, end));
+          responded = true;
+        }
+      }
+    }
+  }
+
+  if (m_stopping) {
+    m_coprocess.reset();
+    return 0s;
+  }
+
+  if (!responded) {
+    m_log.info("script_runner: Restarting coprocess");
+    m_coprocess->terminate();
+    int status = m_coprocess->get_exit_status();
+    m_coprocess.reset();
+    m_data.pid = -1;
+
+    // Ending without an answer is a failure even if the script exited normally
+    if (set_exit_status(status != 0 ? status : EXIT_FAILURE) || changed) {
+      m_on_update(m_data);
+    }
+
+    return std::max(m_interval_fail, interval{1s});
+  }
+
+  if (set_exit_status(0) || changed) {
+    m_on_update(m_data);
+  }
+
+  return m_interval_success;
+}
+
 POLYBAR_NS_END
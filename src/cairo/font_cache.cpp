@@ -0,0 +1,185 @@
+#include "cairo/font_cache.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "errors.hpp"
+#include "utils/env.hpp"
+#include "utils/file.hpp"
+
+POLYBAR_NS
+
+namespace cairo {
+  /**
+   * Written as the first line, bump when the format changes
+   */
+  static constexpr const char* HEADER = "polybar font cache 1";
+
+  font_cache::font_cache(string path, string generation) : m_path(move(path)), m_generation(move(generation)) {
+    load();
+  }
+
+  const font_cache::entry* font_cache::find(const string& key) const {
+    auto it = m_entries.find(key);
+    return it != m_entries.end() ? &it->second : nullptr;
+  }
+
+  void font_cache::insert(const string& key, entry&& value) {
+    // The file format is line and tab separated
+    for (const auto& str : {key, value.pattern}) {
+      if (str.find_first_of("\t\n") != string::npos) {
+        return;
+      }
+    }
+
+    m_entries[key] = move(value);
+    m_dirty = true;
+  }
+
+  void font_cache::save() {
+    if (!m_dirty || m_path.empty()) {
+      return;
+    }
+
+    string contents = string{HEADER} + "\n" + m_generation + "\n";
+    for (const auto& it : m_entries) {
+      contents += it.first + "\t" + it.second.pattern + "\t" + serialize(it.second.chars) + "\n";
+    }
+
+    // Create the cache directory and its parent (usually ~/.cache)
+    auto dir = file_util::dirname(m_path);
+    for (const auto& d : {file_util::dirname(dir.substr(0, dir.size() - 1)), dir}) {
+      if (!d.empty() && !file_util::exists(d) && mkdir(d.c_str(), 0700) == -1 && errno != EEXIST) {
+        throw system_error("Failed to create font cache directory " + d);
+      }
+    }
+
+    // Write to a temporary file first so that no other instance ever reads a partially written cache
+    auto tmp = m_path + "." + to_string(getpid());
+    file_util::write_contents(tmp, contents);
+    if (rename(tmp.c_str(), m_path.c_str()) == -1) {
+      unlink(tmp.c_str());
+      throw system_error("Failed to write font cache " + m_path);
+    }
+
+    m_dirty = false;
+  }
+
+  string font_cache::key(const string& pattern, double dpi_x, double dpi_y) {
+    char dpi[64];
+    snprintf(dpi, sizeof(dpi), ";%g;%g", dpi_x, dpi_y);
+    return pattern + dpi;
+  }
+
+  void font_cache::add(charset& chars, uint32_t codepoint) {
+    if (!chars.empty() && chars.back().second + 1 == codepoint) {
+      chars.back().second = codepoint;
+    } else {
+      chars.emplace_back(codepoint, codepoint);
+    }
+  }
+
+  bool font_cache::contains(const charset& chars, uint32_t codepoint) {
+    auto it = std::upper_bound(chars.begin(), chars.end(), codepoint,
+        [](uint32_t c, const range& r) { return c < r.first; });
+    return it != chars.begin() && codepoint <= (--it)->second;
+  }
+
+  string font_cache::default_path() {
+    if (env_util::has("XDG_CACHE_HOME")) {
+      return env_util::get("XDG_CACHE_HOME") + "/polybar/fonts";
+    } else if (env_util::has("HOME")) {
+      return env_util::get("HOME") + "/.cache/polybar/fonts";
+    }
+    return "";
+  }
+
+  void font_cache::load() {
+    if (m_path.empty()) {
+      return;
+    }
+
+    std::ifstream in(m_path);
+    string line;
+
+    if (!std::getline(in, line) || line != HEADER || !std::getline(in, line) || line != m_generation) {
+      return;
+    }
+
+    while (std::getline(in, line)) {
+      auto first = line.find('\t');
+      auto second = first == string::npos ? string::npos : line.find('\t', first + 1);
+      if (second == string::npos) {
+        continue;
+      }
+
+      entry value{line.substr(first + 1, second - first - 1), {}};
+      if (deserialize(line.substr(second + 1), value.chars)) {
+        m_entries.emplace(line.substr(0, first), move(value));
+      }
+    }
+  }
+
+  /**
+   * Ranges are written as comma separated hexadecimal codepoints, either
+   * `first-last` or a single codepoint.
+   */
+  string font_cache::serialize(const charset& chars) {
+    string result;
+    char buf[32];
+
+    for (const auto& r : chars) {
+      if (r.first == r.second) {
+        snprintf(buf, sizeof(buf), "%s%x", result.empty() ? "" : ",", r.first);
+      } else {
+        snprintf(buf, sizeof(buf), "%s%x-%x", result.empty() ? "" : ",", r.first, r.second);
+      }
+      result += buf;
+    }
+
+    return result;
+  }
+
+  bool font_cache::deserialize(const string& str, charset& chars) {
+    const char* pos = str.c_str();
+
+    while (*pos != '\0') {
+      char* end;
+      range r;
+      r.first = r.second = strtoul(pos, &end, 16);
+      if (end == pos) {
+        return false;
+      }
+
+      if (*end == '-') {
+        pos = end + 1;
+        r.second = strtoul(pos, &end, 16);
+        if (end == pos) {
+          return false;
+        }
+      }
+
+      if (r.second < r.first || (!chars.empty() && r.first <= chars.back().second)) {
+        return false;
+      }
+      chars.push_back(r);
+
+      if (*end == ',') {
+        end++;
+      } else if (*end != '\0') {
+        return false;
+      }
+      pos = end;
+    }
+
+    return true;
+  }
+} // namespace cairo
+
+POLYBAR_NS_END
@@ -15,6 +15,8 @@
 #include "utils/math.hpp"
 #include "utils/restack.hpp"
 #include "utils/string.hpp"
+#include "utils/time.hpp"
+#include "utils/trace.hpp"
 #include "utils/units.hpp"
 #include "x11/atoms.hpp"
 #include "x11/connection.hpp"
@@ -40,10 +42,11 @@ using namespace eventloop;
  * Create instance
  */
 bar::make_type bar::make(loop& loop, const config& config, bool only_initialize_values) {
+  time_util::stopwatch timer;
   auto action_ctxt = make_unique<tags::action_context>();
 
   // clang-format off
-  return std::make_unique<bar>(
+  auto instance = std::make_unique<bar>(
       connection::make(),
       signal_emitter::make(),
       config,
@@ -54,6 +57,12 @@ bar::make_type bar::make(loop& loop, const config& config, bool only_initialize_
       std::move(action_ctxt),
       only_initialize_values);
   // clang-format on
+
+  if (!only_initialize_values) {
+    logger::make().info("Startup: X setup took %lu ms", timer.elapsed());
+  }
+
+  return instance;
 }
 
 /**
@@ -255,6 +264,19 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
     }
   }
 
+#if WITH_XCURSOR
+  // Click cursors take precedence over scroll cursors
+  for (auto&& act : m_opts.actions) {
+    bool is_scroll = act.button == mousebtn::SCROLL_UP || act.button == mousebtn::SCROLL_DOWN;
+    if (!m_opts.cursor_click.empty() && !is_scroll && act.button != mousebtn::NONE) {
+      m_fallback_cursor = m_opts.cursor_click;
+      break;
+    } else if (!m_opts.cursor_scroll.empty() && is_scroll) {
+      m_fallback_cursor = m_opts.cursor_scroll;
+    }
+  }
+#endif
+
   const auto parse_or_throw_color = [&](string key, rgba def) -> rgba {
     try {
       rgba color = m_conf.get(bs, key, def);
@@ -377,6 +399,13 @@ const bar_settings& bar::settings() const {
   return m_opts;
 }
 
+/**
+ * Get the render performance counters
+ */
+const bar::render_stats& bar::stats() const {
+  return m_stats;
+}
+
 /**
  * Parse input string and redraw the bar window
  *
@@ -413,12 +442,18 @@ void bar::parse(string&& data, bool force) {
   m_renderer->begin(rect);
 
   try {
+    perf_util::scoped_timer timer(m_stats.parse);
+    trace_util::span span("parse");
     m_dispatch->parse(settings(), *m_renderer, std::move(data));
   } catch (const exception& err) {
     m_log.err("Failed to parse contents (reason: %s)", err.what());
   }
 
-  m_renderer->end();
+  {
+    perf_util::scoped_timer timer(m_stats.render);
+    trace_util::span span("render");
+    m_renderer->end();
+  }
 
   m_dblclicks.clear();
   for (auto&& action : m_opts.actions) {
@@ -748,10 +783,7 @@ void bar::handle(const evt::motion_notify& evt) {
   m_log.trace("bar: Detected motion: %i at pos(%i, %i)", evt->detail, evt->event_x, evt->event_y);
 #if WITH_XCURSOR
   int motion_pos = evt->event_x;
-  // scroll cursor is less important than click cursor, so we shouldn't return until we are sure there is no click
-  // action
-  bool found_scroll = false;
-  const auto has_action = [&](const vector<mousebtn>& buttons) -> bool {
+  const auto has_action = [&](std::initializer_list<mousebtn> buttons) -> bool {
     for (auto btn : buttons) {
       if (m_action_ctxt->has_action(btn, motion_pos) != tags::NO_ACTION) {
         return true;
@@ -761,6 +793,7 @@ void bar::handle(const evt::motion_notify& evt) {
     return false;
   };
 
+  // scroll cursor is less important than click cursor, so we check for click actions first
   if (!m_opts.cursor_click.empty() && has_action({mousebtn::LEFT, mousebtn::MIDDLE, mousebtn::RIGHT,
                                           mousebtn::DOUBLE_LEFT, mousebtn::DOUBLE_MIDDLE, mousebtn::DOUBLE_RIGHT})) {
     change_cursor(m_opts.cursor_click);
@@ -772,37 +805,7 @@ void bar::handle(const evt::motion_notify& evt) {
     return;
   }
 
-  const auto find_click_area = [&](const action& action) {
-    if (!m_opts.cursor_click.empty() &&
-        !(action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN ||
-            action.button == mousebtn::NONE)) {
-      change_cursor(m_opts.cursor_click);
-      return true;
-    } else if (!m_opts.cursor_scroll.empty() &&
-               (action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN)) {
-      if (!found_scroll) {
-        found_scroll = true;
-      }
-    }
-    return false;
-  };
-
-  for (auto&& action : m_opts.actions) {
-    if (!action.command.empty()) {
-      m_log.trace("Found matching fallback handler");
-      if (find_click_area(action)) {
-        return;
-      }
-    }
-  }
-
-  if (found_scroll) {
-    change_cursor(m_opts.cursor_scroll);
-    return;
-  }
-
-  m_log.trace("No matching cursor area found");
-  change_cursor("default");
+  change_cursor(m_fallback_cursor);
   return;
 #endif
 }
@@ -1,5 +1,6 @@
 #include "components/config.hpp"
 
+#include <algorithm>
 #include <climits>
 #include <cmath>
 #include <fstream>
@@ -16,6 +17,19 @@ POLYBAR_NS
 
 namespace chrono = std::chrono;
 
+/**
+ * @returns The absolute path of the file used in a ${file:...} reference or
+ *          an empty string for any other value
+ */
+static string referenced_file(const string& value) {
+  if (value.compare(0, 7, "${file:") != 0 || value.back() != '}') {
+    return "";
+  }
+
+  auto path = value.substr(7, value.length() - 8);
+  return file_util::expand(path.substr(0, path.find(':')));
+}
+
 /**
  * Get path of loaded file
  */
@@ -26,8 +40,8 @@ const string& config::filepath() const {
 /**
  * Get the section name of the bar in use
  */
-string config::section() const {
-  return BAR_PREFIX + m_barname;
+const string& config::section() const {
+  return m_section;
 }
 
 void config::use_xrm() {
@@ -48,6 +62,149 @@ void config::set_sections(sectionmap_t sections) {
   copy_inherited();
 }
 
+void config::resolve() {
+  m_resolved = false;
+  m_snapshot.clear();
+  m_snapshot_index.clear();
+
+  struct param {
+    const string& section;
+    const string& key;
+    const string& value;
+  };
+
+  vector<param> params;
+
+  for (const auto& section : m_sections) {
+    auto& keys = m_snapshot_index[section.first];
+
+    for (const auto& kv : section.second) {
+      keys.emplace(kv.first, params.size());
+      params.push_back(param{section.first, kv.first, kv.second});
+    }
+  }
+
+  m_snapshot.resize(params.size());
+
+  enum class state { NEW, ACTIVE, DONE };
+  vector<state> states(params.size(), state::NEW);
+  vector<size_t> chain;
+
+  for (size_t i = 0; i < params.size(); i++) {
+    /*
+     * Follow the chain of local references starting at this parameter until
+     * reaching either a value that does not refer to another parameter, a
+     * parameter resolved in an earlier iteration or a parameter of the
+     * current chain (a cycle).
+     */
+    size_t current = i;
+    chain.clear();
+
+    while (states[current] == state::NEW) {
+      states[current] = state::ACTIVE;
+      chain.push_back(current);
+
+      const auto& p = params[current];
+      size_t next = local_reference(p.section, p.value);
+
+      if (next == SIZE_MAX) {
+        auto& entry = m_snapshot[current];
+        auto ref = m_references.find(p.value);
+
+        if (ref != m_references.end()) {
+          entry.value = ref->second.value;
+          entry.error = ref->second.error;
+        } else {
+          try {
+            entry.value = dereference(p.section, p.key, p.value);
+          } catch (...) {
+            entry.error = std::current_exception();
+          }
+
+          if (p.value.compare(0, 7, "${file:") == 0 || p.value.compare(0, 7, "${xrdb:") == 0) {
+            m_references.emplace(p.value, reference{referenced_file(p.value), entry.value, entry.error});
+          }
+        }
+
+        states[current] = state::DONE;
+        chain.pop_back();
+        break;
+      }
+
+      current = next;
+    }
+
+    if (states[current] == state::ACTIVE) {
+      string cycle;
+      for (auto it = std::find(chain.begin(), chain.end(), current); it != chain.end(); it++) {
+        cycle += params[*it].section + "." + params[*it].key + " -> ";
+      }
+      cycle += params[current].section + "." + params[current].key;
+
+      auto error = std::make_exception_ptr(value_error("Reference cycle: " + cycle));
+      for (size_t index : chain) {
+        m_snapshot[index].error = error;
+        states[index] = state::DONE;
+      }
+    } else {
+      // All parameters in the chain have the value of the one they ended at
+      for (size_t index : chain) {
+        m_snapshot[index].value = m_snapshot[current].value;
+        m_snapshot[index].error = m_snapshot[current].error;
+        states[index] = state::DONE;
+      }
+    }
+  }
+
+  m_resolved = true;
+  m_log.trace("config: Resolved %zu parameters", m_snapshot.size());
+}
+
+size_t config::local_reference(const string& section, const string& value) const {
+  if (value.size() < 3 || value.compare(0, 2, "${") != 0 || value.back() != '}') {
+    return SIZE_MAX;
+  }
+
+  auto path = value.substr(2, value.length() - 3);
+  size_t pos = path.find('.');
+
+  if (pos == string::npos || path.compare(0, 4, "env:") == 0 || path.compare(0, 5, "xrdb:") == 0 ||
+      path.compare(0, 5, "file:") == 0) {
+    return SIZE_MAX;
+  }
+
+  // Same replacements as in dereference_local
+  auto ref_section = path.substr(0, pos);
+  if (ref_section == "BAR") {
+    m_log.warn("${BAR.key} is deprecated. Use ${root.key} instead");
+  }
+  ref_section = string_util::replace(ref_section, "BAR", this->section(), 0, 3);
+  ref_section = string_util::replace(ref_section, "root", this->section(), 0, 4);
+  ref_section = string_util::replace(ref_section, "self", section, 0, 4);
+
+  auto it = m_snapshot_index.find(ref_section);
+  if (it == m_snapshot_index.end()) {
+    return SIZE_MAX;
+  }
+
+  auto key_it = it->second.find(path.substr(pos + 1));
+  return key_it == it->second.end() ? SIZE_MAX : key_it->second;
+}
+
+config::value_handle config::handle(const string& section, const string& key) const {
+  auto it = m_snapshot_index.find(section);
+  if (it == m_snapshot_index.end()) {
+    throw key_error("Missing section \"" + section + "\"");
+  }
+
+  auto key_it = it->second.find(key);
+  if (key_it == it->second.end()) {
+    throw key_error("Missing parameter \"" + section + "." + key + "\"");
+  }
+
+  return value_handle{key_it->second};
+}
+
 void config::set_included(file_list included) {
   m_included = move(included);
 }
@@ -56,6 +213,69 @@ file_list config::get_included_files() const {
   return m_included;
 }
 
+file_list config::get_referenced_files() const {
+  file_list files;
+  for (const auto& ref : m_references) {
+    const auto& file = ref.second.file;
+    if (!file.empty() && std::find(files.begin(), files.end(), file) == files.end()) {
+      files.push_back(file);
+    }
+  }
+  return files;
+}
+
+bool config::has_xrdb_references() const {
+  return std::any_of(
+      m_references.begin(), m_references.end(), [](const auto& ref) { return ref.second.file.empty(); });
+}
+
+config config::refresh(const file_list& files, bool xrdb) const {
+  config conf(m_log, string{m_file}, string{m_barname});
+  conf.m_sections = m_sections;
+  conf.m_included = m_included;
+
+#if WITH_XRM
+  conf.m_xrm = m_xrm;
+  if (xrdb && m_xrm) {
+    // Reads the current RESOURCE_MANAGER property
+    conf.m_xrm.reset(new xresource_manager{connection::make()});
+  }
+#endif
+
+  for (const auto& ref : m_references) {
+    const auto& file = ref.second.file;
+    bool changed = file.empty() ? xrdb : std::find(files.begin(), files.end(), file) != files.end();
+    if (!changed) {
+      conf.m_references.insert(ref);
+    }
+  }
+
+  conf.resolve();
+  return conf;
+}
+
+bool config::section_equals(const string& section, const config& other) const {
+  auto values = [&section](const config& conf) {
+    std::map<string, string> result;
+
+    auto it = conf.m_sections.find(section);
+    if (it != conf.m_sections.end()) {
+      for (const auto& param : it->second) {
+        try {
+          result.emplace(param.first, conf.get<string>(section, param.first));
+        } catch (const std::exception& err) {
+          // Invalid references count as equal only if they fail the same way
+          result.emplace(param.first, string{"\0"} + err.what());
+        }
+      }
+    }
+
+    return result;
+  };
+
+  return values(*this) == values(other);
+}
+
 /**
  * Print a deprecation warning if the given parameter is set
  */
@@ -85,17 +305,11 @@ bool config::has(const string& section, const string& key) const {
  * Set parameter value
  */
 void config::set(const string& section, const string& key, string&& value) {
-  auto it = m_sections.find(section);
-  if (it == m_sections.end()) {
-    valuemap_t values;
-    values[key] = value;
-    m_sections[section] = move(values);
-  }
-  auto it2 = it->second.find(key);
-  if ((it2 = it->second.find(key)) == it->second.end()) {
-    it2 = it->second.emplace_hint(it2, key, value);
-  } else {
-    it2->second = value;
+  m_sections[section][key] = move(value);
+
+  // Other parameters may reference this one, so the whole snapshot is stale
+  if (m_resolved) {
+    resolve();
   }
 }
 
@@ -3,10 +3,11 @@
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
-#include <fstream>
 
+#include "utils/concurrency.hpp"
 #include "utils/file.hpp"
 #include "utils/string.hpp"
+#include "utils/time.hpp"
 
 POLYBAR_NS
 
@@ -16,7 +17,11 @@ config_parser::config_parser(const logger& logger, string&& file)
 config config_parser::parse(string barname) {
   m_log.notice("Parsing config file: %s", m_config_file);
 
+  time_util::stopwatch timer;
+  read_files();
   parse_file(m_config_file, {});
+  m_parsed.clear();
+  auto parse_ms = timer.elapsed();
 
   sectionmap_t sections = create_sectionmap();
 
@@ -53,6 +58,11 @@ config config_parser::parse(string barname) {
     conf.use_xrm();
   }
 
+  timer = time_util::stopwatch();
+  conf.resolve();
+  m_log.info("Parsed %zu config file(s) in %lu ms, resolved references in %lu ms", m_files.size(), parse_ms,
+      timer.elapsed());
+
   return conf;
 }
 
@@ -105,84 +115,144 @@ vector<string> config_parser::get_bars(const sectionmap_t& sections) const {
   return bars;
 }
 
-void config_parser::parse_file(const string& file, file_list path) {
-  if (std::find(path.begin(), path.end(), file) != path.end()) {
-    string path_str{};
+void config_parser::read_files() {
+  auto file_index = [this](const string& file) -> int {
+    auto found = std::find(m_files.begin(), m_files.end(), file);
+    if (found == m_files.end()) {
+      m_files.push_back(file);
+      return m_files.size() - 1;
+    }
 
-    for (const auto& p : path) {
-      path_str += ">\t" + p + "\n";
+    /*
+     * `file` is already in the `files` vector so we calculate its index.
+     *
+     * This can happen in tests, where the file list is set up in advance
+     */
+    return found - m_files.begin();
+  };
+
+  vector<string> wave{m_config_file};
+
+  while (!wave.empty()) {
+    // m_files may only change between waves, read_file accesses it from the worker threads
+    vector<int> indices;
+    for (const auto& file : wave) {
+      indices.push_back(file_index(file));
     }
 
-    path_str += ">\t" + file;
+    vector<parsed_file> results(wave.size());
+    concurrency_util::parallel_for(wave.size(), [&](size_t i) { results[i] = read_file(wave[i], indices[i]); });
+
+    vector<string> next;
+    for (size_t i = 0; i < wave.size(); i++) {
+      for (const auto& include : results[i].includes) {
+        if (m_parsed.find(include.second) == m_parsed.end() &&
+            std::find(wave.begin(), wave.end(), include.second) == wave.end() &&
+            std::find(next.begin(), next.end(), include.second) == next.end()) {
+          next.push_back(include.second);
+        }
+      }
+      m_parsed.emplace(wave[i], move(results[i]));
+    }
 
-    // We have already parsed this file in this path, so there are cyclic dependencies
-    throw application_error("include-file: Dependency cycle detected:\n" + path_str);
+    wave = move(next);
   }
+}
 
-  if (!file_util::exists(file)) {
-    throw application_error("Failed to open config file " + file + ": " + strerror(errno));
-  }
+config_parser::parsed_file config_parser::read_file(const string& file, int file_index) {
+  parsed_file result;
 
-  if (file_util::is_dir(file)) {
-    throw application_error("Config file " + file + " is a directory");
-  }
+  try {
+    if (!file_util::exists(file)) {
+      throw application_error("Failed to open config file " + file + ": " + strerror(errno));
+    }
 
-  m_log.trace("config_parser: Parsing %s", file);
+    if (file_util::is_dir(file)) {
+      throw application_error("Config file " + file + " is a directory");
+    }
 
-  int file_index;
+    m_log.trace("config_parser: Parsing %s", file);
 
-  auto found = std::find(m_files.begin(), m_files.end(), file);
+    unique_ptr<mapped_file> contents;
+    try {
+      contents = make_unique<mapped_file>(file);
+    } catch (const system_error& err) {
+      throw application_error("Failed to open config file " + file + ": " + err.what());
+    }
 
-  if (found == m_files.end()) {
-    file_index = m_files.size();
-    m_files.push_back(file);
-  } else {
-    /*
-     * `file` is already in the `files` vector so we calculate its index.
-     *
-     * This means that the file was already parsed, this can happen without
-     * cyclic dependencies, if the file is included twice
-     */
-    file_index = found - m_files.begin();
+    auto dirname = file_util::dirname(file);
+    const char* pos = contents->data();
+    const char* end = pos + contents->size();
+    int line_no = 0;
+
+    while (pos < end) {
+      auto eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (eol == nullptr) {
+        eol = end;
+      }
+
+      line_no++;
+      line_t line;
+      line.file_index = file_index;
+      line.line_no = line_no;
+      parse_line(line, string(pos, eol));
+      pos = eol + 1;
+
+      // Skip useless lines (comments, empty lines)
+      if (!line.useful) {
+        continue;
+      }
+
+      if (!line.is_header && line.key == "include-file") {
+        result.includes.emplace_back(result.lines.size(), file_util::expand(line.value, dirname));
+      } else if (!line.is_header && line.key == "include-directory") {
+        const string expanded_path = file_util::expand(line.value, dirname);
+        vector<string> file_list = file_util::list_files(expanded_path);
+        sort(file_list.begin(), file_list.end());
+        for (const auto& filename : file_list) {
+          result.includes.emplace_back(result.lines.size(), expanded_path + "/" + filename);
+        }
+      } else {
+        result.lines.push_back(move(line));
+      }
+    }
+  } catch (...) {
+    result.error = std::current_exception();
   }
 
-  path.push_back(file);
+  return result;
+}
 
-  int line_no = 0;
+void config_parser::parse_file(const string& file, file_list path) {
+  if (std::find(path.begin(), path.end(), file) != path.end()) {
+    string path_str{};
 
-  string line_str{};
+    for (const auto& p : path) {
+      path_str += ">\t" + p + "\n";
+    }
 
-  std::ifstream in(file);
+    path_str += ">\t" + file;
 
-  if (!in) {
-    throw application_error("Failed to open config file " + file + ": " + strerror(errno));
+    // We have already parsed this file in this path, so there are cyclic dependencies
+    throw application_error("include-file: Dependency cycle detected:\n" + path_str);
   }
 
-  auto dirname = file_util::dirname(file);
+  const auto& parsed = m_parsed.at(file);
+  if (parsed.error) {
+    std::rethrow_exception(parsed.error);
+  }
 
-  while (std::getline(in, line_str)) {
-    line_no++;
-    line_t line;
-    line.file_index = file_index;
-    line.line_no = line_no;
-    parse_line(line, line_str);
+  path.push_back(file);
 
-    // Skip useless lines (comments, empty lines)
-    if (!line.useful) {
-      continue;
+  auto include = parsed.includes.begin();
+  for (size_t i = 0; i <= parsed.lines.size(); i++) {
+    // Includes are placed before the line that followed them in the file
+    for (; include != parsed.includes.end() && include->first == i; include++) {
+      parse_file(include->second, path);
     }
 
-    if (!line.is_header && line.key == "include-file") {
-      parse_file(file_util::expand(line.value, dirname), path);
-    } else if (!line.is_header && line.key == "include-directory") {
-      const string expanded_path = file_util::expand(line.value, dirname);
-      vector<string> file_list = file_util::list_files(expanded_path);
-      sort(file_list.begin(), file_list.end());
-      for (const auto& filename : file_list) {
-        parse_file(expanded_path + "/" + filename, path);
-      }
-    } else {
-      m_lines.push_back(line);
+    if (i < parsed.lines.size()) {
+      m_lines.push_back(parsed.lines[i]);
     }
   }
 }
@@ -1,26 +1,36 @@
 #include "components/controller.hpp"
 
-#include <csignal>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <csignal>
+#include <cstring>
 #include <utility>
 
 #include "components/bar.hpp"
 #include "components/builder.hpp"
 #include "components/config.hpp"
+#include "components/config_parser.hpp"
 #include "components/eventloop.hpp"
 #include "components/logger.hpp"
 #include "components/types.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
+#include "ipc/util.hpp"
 #include "modules/meta/all.hpp"
 #include "modules/meta/base.hpp"
 #include "modules/meta/event_handler.hpp"
 #include "modules/meta/factory.hpp"
 #include "utils/actions.hpp"
+#include "utils/concurrency.hpp"
 #include "utils/inotify.hpp"
+#include "utils/launcher.hpp"
+#include "utils/prefix_trie.hpp"
 #include "utils/process.hpp"
 #include "utils/string.hpp"
 #include "utils/time.hpp"
+#include "utils/trace.hpp"
 #include "x11/connection.hpp"
 #include "x11/extensions/all.hpp"
 
@@ -29,26 +39,32 @@ POLYBAR_NS
 using namespace eventloop;
 using namespace modules;
 
+/**
+ * Time to wait for further changes to the config files before reloading
+ */
+static constexpr uint64_t CONFWATCH_DELAY_MS = 100;
+
 /**
  * Build controller instance
  */
-controller::make_type controller::make(bool has_ipc, loop& loop, const config& config) {
+controller::make_type controller::make(bool has_ipc, loop& loop, const config& config, launcher* click_launcher) {
   return std::make_unique<controller>(
-      connection::make(), signal_emitter::make(), logger::make(), config, has_ipc, loop);
+      connection::make(), signal_emitter::make(), logger::make(), config, has_ipc, loop, click_launcher);
 }
 
 /**
  * Construct controller
  */
-controller::controller(
-    connection& conn, signal_emitter& emitter, const logger& logger, const config& config, bool has_ipc, loop& loop)
+controller::controller(connection& conn, signal_emitter& emitter, const logger& logger, const config& config,
+    bool has_ipc, loop& loop, launcher* click_launcher)
     : m_connection(conn)
     , m_sig(emitter)
     , m_log(logger)
     , m_conf(config)
     , m_loop(loop)
     , m_bar(bar::make(m_loop, config))
-    , m_has_ipc(has_ipc) {
+    , m_has_ipc(has_ipc)
+    , m_launcher(click_launcher) {
   m_conf.warn_deprecated("settings", "throttle-input-for");
   m_conf.warn_deprecated("settings", "throttle-output");
   m_conf.warn_deprecated("settings", "throttle-output-for");
@@ -56,10 +72,7 @@ controller::controller(
   m_conf.warn_deprecated("settings", "eventqueue-swallow-time");
 
   m_log.trace("controller: Setup user-defined modules");
-  size_t created_modules{0};
-  created_modules += setup_modules(alignment::LEFT);
-  created_modules += setup_modules(alignment::CENTER);
-  created_modules += setup_modules(alignment::RIGHT);
+  size_t created_modules = setup_modules();
 
   if (!created_modules) {
     throw application_error("No modules created");
@@ -75,6 +88,10 @@ controller::~controller() {
   m_log.trace("controller: Detach signal receiver");
   m_sig.detach(this);
 
+  if (m_xrdb_watched) {
+    m_connection.detach_sink(this, SINK_PRIORITY_SCREEN);
+  }
+
   m_log.trace("controller: Stop modules");
   for (auto&& module : m_modules) {
     auto module_name = module->name();
@@ -152,8 +169,21 @@ void controller::conn_cb() {
     return;
   }
 
-  shared_ptr<xcb_generic_event_t> evt{};
-  while ((evt = m_connection.poll_for_event()) != nullptr) {
+  read_x_events();
+  compress_x_events();
+
+  for (auto& event : m_x_events) {
+    if (!event) {
+      continue;
+    }
+
+    /*
+     * The registry only accepts shared pointers. The event is owned by
+     * m_x_events, so a non-owning shared_ptr (aliasing an empty one) is used
+     * to avoid allocating a control block for every event.
+     */
+    shared_ptr<xcb_generic_event_t> evt(shared_ptr<void>{}, event.get());
+
     try {
       m_connection.dispatch_event(evt);
     } catch (xpp::connection_error& err) {
@@ -165,6 +195,8 @@ void controller::conn_cb() {
     }
   }
 
+  m_x_events.clear();
+
   if ((xcb_error = m_connection.connection_has_error()) != 0) {
     m_log.err("X connection error, terminating... (what: %s)", m_connection.error_str(xcb_error));
     stop(false);
@@ -172,6 +204,52 @@ void controller::conn_cb() {
   }
 }
 
+/**
+ * Drains all queued events from the X connection into m_x_events
+ */
+void controller::read_x_events() {
+  xcb_generic_event_t* evt;
+  while ((evt = xcb_poll_for_event(m_connection)) != nullptr) {
+    m_x_events.emplace_back(evt, free);
+  }
+}
+
+/**
+ * Drops all but the newest motion and configure event for each window.
+ *
+ * Older events of these types only describe an outdated pointer position or
+ * window geometry. Dropping them means dragging the pointer across the bar
+ * causes a constant number of hit tests per loop iteration.
+ */
+void controller::compress_x_events() {
+  if (m_x_events.size() < 2) {
+    return;
+  }
+
+  // (response type, window) of the events that were already kept
+  vector<pair<uint8_t, xcb_window_t>> seen;
+
+  for (auto it = m_x_events.rbegin(); it != m_x_events.rend(); it++) {
+    uint8_t type = (*it)->response_type & ~0x80;
+    xcb_window_t window;
+
+    if (type == XCB_MOTION_NOTIFY) {
+      window = reinterpret_cast<xcb_motion_notify_event_t*>(it->get())->event;
+    } else if (type == XCB_CONFIGURE_NOTIFY) {
+      window = reinterpret_cast<xcb_configure_notify_event_t*>(it->get())->window;
+    } else {
+      continue;
+    }
+
+    auto key = make_pair(type, window);
+    if (std::find(seen.begin(), seen.end(), key) != seen.end()) {
+      it->reset();
+    } else {
+      seen.push_back(key);
+    }
+  }
+}
+
 void controller::signal_handler(int signum) {
   m_log.notice("Received signal(%d): %s", signum, strsignal(signum));
   stop(signum == SIGUSR1);
@@ -185,14 +263,257 @@ void controller::create_config_watcher(const string& filename) {
         m_log.err("libuv error while watching included file for changes: %s", uv_strerror(e.status));
         handle.close();
       });
+  m_config_watchers.push_back(fs_event_handle);
+}
+
+void controller::create_reference_watcher(const string& filename) {
+  auto fs_event_handle = m_loop.handle<FSEventHandle>();
+  fs_event_handle->start(
+      filename, 0, [this, filename](const auto&) { reference_handler(filename); },
+      [this, &handle = *fs_event_handle](const auto& e) {
+        m_log.err("libuv error while watching referenced file for changes: %s", uv_strerror(e.status));
+        handle.close();
+      });
+  m_config_watchers.push_back(fs_event_handle);
+}
+
+/**
+ * (Re-)create watchers for the config file, all included files and all files
+ * used in ${file:...} references
+ *
+ * Editors often replace files instead of writing to them, the old watchers
+ * would then not see any further changes.
+ */
+void controller::watch_config(const config& conf) {
+  for (auto&& handle : m_config_watchers) {
+    handle->close();
+  }
+  m_config_watchers.clear();
+
+  create_config_watcher(conf.filepath());
+  // also watch the include-files for changes
+  for (auto& module_path : conf.get_included_files()) {
+    create_config_watcher(module_path);
+  }
+
+  // References to missing files use their fallback value and cannot be watched
+  for (auto& file : conf.get_referenced_files()) {
+    if (file_util::exists(file)) {
+      create_reference_watcher(file);
+    }
+  }
+
+  if (!m_xrdb_watched && conf.has_xrdb_references()) {
+    // The X resources are stored in the RESOURCE_MANAGER property of the root window
+    m_connection.ensure_event_mask(m_connection.root(), XCB_EVENT_MASK_PROPERTY_CHANGE);
+    m_connection.flush();
+    m_connection.attach_sink(this, SINK_PRIORITY_SCREEN);
+    m_xrdb_watched = true;
+  }
 }
 
 void controller::confwatch_handler(const char* filename) {
   m_log.notice("Watched config file changed %s", filename);
-  stop(true);
+  m_config_changed = true;
+  start_confwatch_timer();
+}
+
+void controller::reference_handler(const string& filename) {
+  m_log.notice("Referenced file changed %s", filename);
+  if (std::find(m_changed_references.begin(), m_changed_references.end(), filename) == m_changed_references.end()) {
+    m_changed_references.push_back(filename);
+  }
+  start_confwatch_timer();
+}
+
+void controller::handle(const evt::property_notify& evt) {
+  if (evt->window == m_connection.root() && evt->atom == XCB_ATOM_RESOURCE_MANAGER) {
+    m_log.notice("X resources changed");
+    m_xrdb_changed = true;
+    start_confwatch_timer();
+  }
+}
+
+/**
+ * Saving a file often produces multiple events, only reload once they stop
+ *
+ * A change to the config files reparses the whole config, otherwise only the
+ * changed references are read again.
+ */
+void controller::start_confwatch_timer() {
+  if (!m_confwatch_timer) {
+    m_confwatch_timer = m_loop.handle<TimerHandle>();
+  }
+  m_confwatch_timer->start(CONFWATCH_DELAY_MS, 0, [this]() {
+    if (m_config_changed) {
+      reload_config();
+    } else {
+      refresh_references();
+    }
+
+    m_config_changed = false;
+    m_changed_references.clear();
+    m_xrdb_changed = false;
+  });
+}
+
+/**
+ * Reap shell commands started for input data on SIGCHLD until all of them
+ * have exited
+ */
+void controller::start_reaper() {
+  if (!m_reaper) {
+    m_reaper = m_loop.handle<SignalHandle>();
+  }
+  if (!m_reaper->is_active()) {
+    m_reaper->start(SIGCHLD, [this](const auto&) {
+      if (process_util::reap_detached() == 0) {
+        m_reaper->stop();
+      }
+    });
+  }
+
+  // The command may have exited before the handler was installed
+  if (process_util::reap_detached() == 0) {
+    m_reaper->stop();
+  }
+}
+
+const config& controller::current_config() const {
+  return m_current_config ? *m_current_config : m_conf;
+}
+
+/**
+ * Parse the config again and recreate only the modules whose section changed
+ */
+void controller::reload_config() {
+  time_util::stopwatch timer;
+  shared_ptr<config> conf;
+
+  try {
+    config_parser parser{m_log, string{m_conf.filepath()}};
+    conf = make_shared<config>(parser.parse(m_conf.section().substr(strlen(config::BAR_PREFIX))));
+  } catch (const std::exception& err) {
+    m_log.err("Failed to reload config, keeping the current one (reason: %s)", err.what());
+    return;
+  }
+
+  if (apply_config(conf)) {
+    m_log.notice("Reloaded config in %lu ms", timer.elapsed());
+  }
+}
+
+/**
+ * Read the changed ${file:...} and ${xrdb:...} references again
+ *
+ * Only the modules that use one of the changed values are recreated.
+ */
+void controller::refresh_references() {
+  time_util::stopwatch timer;
+  auto conf = make_shared<config>(current_config().refresh(m_changed_references, m_xrdb_changed));
+
+  if (apply_config(conf)) {
+    m_log.notice("Updated config references in %lu ms", timer.elapsed());
+  }
+}
+
+/**
+ * Switch to the given config, recreating only the modules whose section changed
+ *
+ * Changes to the bar section or the global settings (which includes the
+ * module lists) and changes to the tray module still restart the whole bar.
+ *
+ * @returns false if the bar is restarted instead
+ */
+bool controller::apply_config(const shared_ptr<config>& conf) {
+  if (!conf->section_equals(m_conf.section(), m_conf) || !conf->section_equals("settings", m_conf)) {
+    m_log.notice("Bar settings changed, restarting");
+    stop(true);
+    return false;
+  }
+
+  vector<module_t> changed;
+  for (const auto& module : m_modules) {
+    auto it = m_module_configs.find(module->name_raw());
+    const config& current = it == m_module_configs.end() ? m_conf : *it->second;
+
+    if (conf->section_equals(module->name(), current)) {
+      continue;
+    }
+
+    if (module->type() == tray_module::TYPE || conf->get(module->name(), "type", ""s) == tray_module::TYPE) {
+      m_log.notice("Tray module '%s' changed, restarting", module->name_raw());
+      stop(true);
+      return false;
+    }
+
+    changed.push_back(module);
+  }
+
+  for (auto&& old : changed) {
+    m_log.notice("Reloading module '%s'", old->name_raw());
+
+    auto evt_handler = dynamic_cast<event_handler_interface*>(&*old);
+    if (evt_handler != nullptr) {
+      evt_handler->disconnect(m_connection);
+    }
+
+    module_t module;
+    try {
+      auto type = conf->get(old->name(), "type");
+
+      if (type == ipc_module::TYPE && !m_has_ipc) {
+        throw application_error("Inter-process messaging needs to be enabled");
+      }
+
+      module = modules::make_module(move(type), m_bar->settings(), old->name_raw(), m_log, *conf);
+
+      evt_handler = dynamic_cast<event_handler_interface*>(&*module);
+      if (evt_handler != nullptr) {
+        evt_handler->connect(m_connection);
+      }
+
+      module->start();
+    } catch (const std::exception& err) {
+      m_log.err("Disabling module \"%s\" (reason: %s)", old->name_raw(), err.what());
+      module.reset();
+    }
+
+    vector<vector<module_t>*> lists{&m_modules};
+    for (auto&& block : m_blocks) {
+      lists.push_back(&block.second);
+    }
+    modules::replace_module(old, module, lists);
+  }
+
+  m_modules_by_name.clear();
+  m_modules_by_type.clear();
+  for (const auto& module : m_modules) {
+    m_modules_by_name[module->name_raw()].push_back(module);
+    m_modules_by_type.emplace(module->type(), module);
+  }
+
+  // Drop the old modules before the configs they reference
+  for (auto&& old : changed) {
+    auto name = old->name_raw();
+    old.reset();
+    m_module_configs[name] = conf;
+  }
+  changed.clear();
+
+  for (auto it = m_module_configs.begin(); it != m_module_configs.end();) {
+    it = m_modules_by_name.count(it->first) ? std::next(it) : m_module_configs.erase(it);
+  }
+
+  m_current_config = conf;
+  watch_config(*conf);
+
+  trigger_update(true);
+  return true;
 }
 
 void controller::notifier_handler() {
+  trace_util::span span("notifier_handler");
   notifications_t data{};
 
   {
@@ -222,27 +543,70 @@ void controller::screenshot_handler() {
   trigger_update(true);
 }
 
+/**
+ * Start all modules
+ *
+ * Modules that need the X connection are started on the main thread, all
+ * others are started in parallel.
+ */
 void controller::start_modules() {
-  size_t started_modules{0};
-  for (const auto& module : m_modules) {
-    auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
+  time_util::stopwatch timer;
 
-    if (evt_handler != nullptr) {
-      evt_handler->connect(m_connection);
-    }
+  struct start_result {
+    bool started{false};
+    string error{};
+    chrono::milliseconds::rep duration{0};
+  };
+
+  vector<start_result> results(m_modules.size());
+  vector<size_t> parallel;
+
+  auto start = [&](size_t i) {
+    const auto& module = m_modules[i];
+    time_util::stopwatch module_timer;
 
     try {
       m_log.info("Starting %s", module->name());
       module->start();
-      started_modules++;
+      results[i].started = true;
     } catch (const application_error& err) {
-      m_log.err("Failed to start '%s' (reason: %s)", module->name(), err.what());
+      results[i].error = err.what();
+    }
+
+    results[i].duration = module_timer.elapsed();
+  };
+
+  for (size_t i = 0; i < m_modules.size(); i++) {
+    auto evt_handler = dynamic_cast<event_handler_interface*>(&*m_modules[i]);
+
+    if (evt_handler != nullptr) {
+      evt_handler->connect(m_connection);
+    }
+
+    if (modules::needs_main_thread(m_modules[i]->type())) {
+      start(i);
+    } else {
+      parallel.push_back(i);
+    }
+  }
+
+  concurrency_util::parallel_for(parallel.size(), [&](size_t i) { start(parallel[i]); });
+
+  size_t started_modules{0};
+  for (size_t i = 0; i < m_modules.size(); i++) {
+    if (results[i].started) {
+      m_log.info("Startup: Starting %s took %lu ms", m_modules[i]->name(), results[i].duration);
+      started_modules++;
+    } else {
+      m_log.err("Failed to start '%s' (reason: %s)", m_modules[i]->name(), results[i].error);
     }
   }
 
   if (!started_modules) {
     throw application_error("No modules started");
   }
+
+  m_log.info("Startup: Starting %zu modules took %lu ms", started_modules, timer.elapsed());
 }
 
 /**
@@ -282,11 +646,7 @@ void controller::read_events(bool confwatch) {
   }
 
   if (confwatch) {
-    create_config_watcher(m_conf.filepath());
-    // also watch the include-files for changes
-    for (auto& module_path : m_conf.get_included_files()) {
-      create_config_watcher(module_path);
-    }
+    watch_config(m_conf);
   }
 
   if (!m_snapshot_dst.empty()) {
@@ -332,7 +692,14 @@ bool controller::try_forward_legacy_action(const string& cmd) {
 // clang-format off
 #define A_MAP(old, module_name, event) {old, {string(module_name::TYPE), string(module_name::event)}}
 
-  static const std::unordered_map<string, std::pair<string, const string>> legacy_actions{
+  using legacy_entry = std::pair<string, std::pair<string, string>>;
+  static const auto legacy_actions = [](std::initializer_list<legacy_entry> entries) {
+    prefix_trie<std::pair<string, string>> trie;
+    for (const auto& entry : entries) {
+      trie.insert(entry.first, entry.second);
+    }
+    return trie;
+  }({
     A_MAP("datetoggle", date_module, EVENT_TOGGLE),
 #if ENABLE_ALSA
     A_MAP("volup", alsa_module, EVENT_INC),
@@ -381,39 +748,39 @@ bool controller::try_forward_legacy_action(const string& cmd) {
     // Has data
     A_MAP("menu-open-", menu_module, EVENT_OPEN),
     A_MAP("menu-close", menu_module, EVENT_CLOSE),
-  };
+  });
 #undef A_MAP
   // clang-format on
 
-  // Check if any key in the map is a prefix for the `cmd`
-  for (const auto& entry : legacy_actions) {
-    const auto& key = entry.first;
-    if (cmd.compare(0, key.length(), key) == 0) {
-      string type = entry.second.first;
-      auto data = cmd.substr(key.length());
-      string action = entry.second.second;
-
-      // Search for the first module that matches the type for this legacy action
-      for (auto&& module : m_modules) {
-        if (module->type() == type) {
-          auto module_name = module->name_raw();
-          if (data.empty()) {
-            m_log.warn("The action '%s' is deprecated, use '#%s.%s' instead!", cmd, module_name, action);
-          } else {
-            m_log.warn("The action '%s' is deprecated, use '#%s.%s.%s' instead!", cmd, module_name, action, data);
-          }
-          m_log.warn("Consult the 'Actions' page in the polybar documentation for more information.");
-          m_log.info(
-              "Forwarding legacy action '%s' to module '%s' as '%s' with data '%s'", cmd, module_name, action, data);
-          if (!module->input(action, data)) {
-            m_log.err("Failed to forward deprecated action to %s module", type);
-            // Forward to shell if the module cannot accept the action to not break existing behavior.
-            return false;
-          }
-          // Only deliver to the first matching module.
-          return true;
-        }
+  // Find the legacy action that is a prefix of `cmd`
+  size_t key_length = 0;
+  const auto* entry = legacy_actions.match(cmd, key_length);
+
+  if (entry != nullptr) {
+    const string& type = entry->first;
+    const string& action = entry->second;
+    auto data = cmd.substr(key_length);
+
+    // Search for the first module that matches the type for this legacy action
+    auto it = m_modules_by_type.find(type);
+    if (it != m_modules_by_type.end()) {
+      const auto& module = it->second;
+      const auto& module_name = module->name_raw();
+      if (data.empty()) {
+        m_log.warn("The action '%s' is deprecated, use '#%s.%s' instead!", cmd, module_name, action);
+      } else {
+        m_log.warn("The action '%s' is deprecated, use '#%s.%s.%s' instead!", cmd, module_name, action, data);
+      }
+      m_log.warn("Consult the 'Actions' page in the polybar documentation for more information.");
+      m_log.info(
+          "Forwarding legacy action '%s' to module '%s' as '%s' with data '%s'", cmd, module_name, action, data);
+      if (!module->input(action, data)) {
+        m_log.err("Failed to forward deprecated action to %s module", type);
+        // Forward to shell if the module cannot accept the action to not break existing behavior.
+        return false;
       }
+      // Only deliver to the first matching module.
+      return true;
     }
   }
 
@@ -425,30 +792,31 @@ bool controller::try_forward_legacy_action(const string& cmd) {
 }
 
 bool controller::forward_action(const actions_util::action& action_triple) {
-  string module_name = std::get<0>(action_triple);
-  string action = std::get<1>(action_triple);
-  string data = std::get<2>(action_triple);
+  const string& module_name = std::get<0>(action_triple);
+  const string& action = std::get<1>(action_triple);
+  const string& data = std::get<2>(action_triple);
 
   m_log.info("Forwarding action to modules (module: '%s', action: '%s', data: '%s')", module_name, action, data);
 
-  int num_delivered = 0;
+  size_t num_delivered = 0;
 
   // Forwards the action to all modules that match the name
-  for (auto&& module : m_modules) {
-    if (module->name_raw() == module_name) {
+  auto it = m_modules_by_name.find(module_name);
+  if (it != m_modules_by_name.end()) {
+    for (const auto& module : it->second) {
       if (!module->input(action, data)) {
         m_log.err("The '%s' module does not support the '%s' action.", module_name, action);
       }
-
-      num_delivered++;
     }
+
+    num_delivered = it->second.size();
   }
 
   if (num_delivered == 0) {
     m_log.err("Could not forward action to module: No module named '%s' (action: '%s', data: '%s')", module_name,
         action, data);
   } else {
-    m_log.info("Delivered action to %d module%s", num_delivered, num_delivered > 1 ? "s" : "");
+    m_log.info("Delivered action to %zu module%s", num_delivered, num_delivered > 1 ? "s" : "");
   }
   return true;
 }
@@ -478,8 +846,13 @@ void controller::process_inputdata(string&& cmd) {
     // Run input as command if it's not an input for a module
     m_log.info("Forwarding command to shell... (input: %s)", cmd);
     m_log.info("Executing shell command: %s", cmd);
-    process_util::fork_detached([cmd] { process_util::exec_sh(cmd.c_str()); });
-    process_update(true);
+    if (!m_launcher || !m_launcher->run(cmd)) {
+      if (m_launcher) {
+        m_log.warn("controller: Click launcher is not available, executing command directly");
+      }
+      process_util::spawn_detached(cmd);
+      start_reaper();
+    }
   } catch (const application_error& err) {
     m_log.err("controller: Error while forwarding input to shell -> %s", err.what());
   }
@@ -489,6 +862,8 @@ void controller::process_inputdata(string&& cmd) {
  * Process eventqueue update event
  */
 bool controller::process_update(bool force) {
+  perf_util::scoped_timer timer(m_update_time);
+  trace_util::span span("process_update");
   const bar_settings& bar{m_bar->settings()};
   string contents;
   string padding_left = builder::get_spacing_format_string(bar.padding.left);
@@ -583,64 +958,100 @@ void controller::update_reload(bool reload) {
 }
 
 /**
- * Creates module instances for all the modules in the given alignment block
+ * Create all modules listed in modules-left, modules-center and modules-right
+ *
+ * Modules are independent of each other, so all modules that don't need the X
+ * connection are constructed in parallel. They are registered in the
+ * configured order afterwards.
+ *
+ * @returns Number of created modules
  */
-size_t controller::setup_modules(alignment align) {
-  string key;
+size_t controller::setup_modules() {
+  time_util::stopwatch timer;
+
+  struct pending_module {
+    alignment align;
+    string name;
+    string type;
+    module_t module{};
+    string error{};
+    chrono::milliseconds::rep duration{0};
+  };
 
-  switch (align) {
-    case alignment::LEFT:
-      key = "modules-left";
-      break;
+  vector<pending_module> pending;
 
-    case alignment::CENTER:
-      key = "modules-center";
-      break;
+  for (const auto& block : {std::make_pair(alignment::LEFT, "modules-left"),
+           std::make_pair(alignment::CENTER, "modules-center"), std::make_pair(alignment::RIGHT, "modules-right")}) {
+    string configured_modules = m_conf.get(m_conf.section(), block.second, ""s);
 
-    case alignment::RIGHT:
-      key = "modules-right";
-      break;
+    for (auto& module_name : string_util::split(configured_modules, ' ')) {
+      if (module_name.empty()) {
+        continue;
+      }
 
-    case alignment::NONE:
-      m_log.err("controller: Tried to setup modules for alignment NONE");
-      break;
-  }
+      try {
+        auto type = m_conf.get("module/" + module_name, "type");
 
-  string configured_modules;
-  if (!key.empty()) {
-    configured_modules = m_conf.get(m_conf.section(), key, ""s);
-  }
+        if (type == tray_module::TYPE) {
+          if (!m_tray_module_name.empty()) {
+            throw module_error("Multiple trays defined. Using tray `" + m_tray_module_name + "`");
+          }
+          m_tray_module_name = module_name;
+        }
 
-  for (auto& module_name : string_util::split(configured_modules, ' ')) {
-    if (module_name.empty()) {
-      continue;
+        if (type == ipc_module::TYPE && !m_has_ipc) {
+          throw application_error("Inter-process messaging needs to be enabled");
+        }
+
+        m_log.notice("Loading module '%s' of type '%s'", module_name, type);
+        pending.push_back({block.first, module_name, move(type)});
+      } catch (const std::exception& err) {
+        m_log.err("Disabling module \"%s\" (reason: %s)", module_name, err.what());
+      }
     }
+  }
+
+  auto create = [&](pending_module& entry) {
+    time_util::stopwatch module_timer;
 
     try {
-      auto type = m_conf.get("module/" + module_name, "type");
+      entry.module = modules::make_module(string{entry.type}, m_bar->settings(), entry.name, m_log, m_conf);
+    } catch (const std::exception& err) {
+      entry.error = err.what();
+    }
 
-      if (type == tray_module::TYPE) {
-        if (!m_tray_module_name.empty()) {
-          throw module_error("Multiple trays defined. Using tray `" + m_tray_module_name + "`");
-        }
-        m_tray_module_name = module_name;
-      }
+    entry.duration = module_timer.elapsed();
+  };
 
-      if (type == ipc_module::TYPE && !m_has_ipc) {
-        throw application_error("Inter-process messaging needs to be enabled");
-      }
+  vector<size_t> parallel;
+  for (size_t i = 0; i < pending.size(); i++) {
+    if (modules::needs_main_thread(pending[i].type)) {
+      create(pending[i]);
+    } else {
+      parallel.push_back(i);
+    }
+  }
 
-      m_log.notice("Loading module '%s' of type '%s'", module_name, type);
-      module_t module = modules::make_module(move(type), m_bar->settings(), module_name, m_log, m_conf);
+  concurrency_util::parallel_for(parallel.size(), [&](size_t i) { create(pending[parallel[i]]); });
 
-      m_modules.push_back(module);
-      m_blocks[align].push_back(module);
-    } catch (const std::exception& err) {
-      m_log.err("Disabling module \"%s\" (reason: %s)", module_name, err.what());
+  for (auto&& entry : pending) {
+    if (!entry.module) {
+      m_log.err("Disabling module \"%s\" (reason: %s)", entry.name, entry.error);
+      continue;
     }
+
+    m_log.info("Startup: Creating module '%s' took %lu ms", entry.name, entry.duration);
+
+    const auto& module = entry.module;
+    m_modules.push_back(module);
+    m_modules_by_name[module->name_raw()].push_back(module);
+    m_modules_by_type.emplace(module->type(), module);
+    m_blocks[entry.align].push_back(module);
   }
 
-  return m_blocks[align].size();
+  m_log.info("Startup: Creating %zu modules took %lu ms", m_modules.size(), timer.elapsed());
+
+  return m_modules.size();
 }
 
 /**
@@ -732,6 +1143,24 @@ bool controller::on(const signals::ipc::command& evt) {
     m_bar->show();
   } else if (command == "toggle") {
     m_bar->toggle();
+  } else if (command == "trace-start") {
+    // Keep writing to the file given on the command line, if any
+    string path = trace_util::path();
+    if (path.empty()) {
+      path = ipc::ensure_runtime_path() + "/trace." + to_string(getpid()) + ".json";
+    }
+    trace_util::start(path);
+    m_log.notice("Recording trace events, write them to '%s' with 'trace-dump'", path);
+  } else if (command == "trace-stop") {
+    trace_util::stop();
+    m_log.notice("Stopped recording trace events");
+  } else if (command == "trace-dump") {
+    try {
+      m_log.notice("Wrote trace events to '%s'", trace_util::dump());
+    } catch (const std::system_error& err) {
+      m_log.err("Failed to write trace events (%s)", err.what());
+      return false;
+    }
   } else {
     m_log.warn("\"%s\" is not a valid ipc command", command);
     return false;
@@ -759,6 +1188,83 @@ bool controller::on(const signals::ipc::hook& evt) {
   return true;
 }
 
+/**
+ * Process ipc stats requests
+ */
+bool controller::on(const signals::ipc::stats& evt) {
+  auto request = evt.cast();
+
+  if (request.format.empty() || request.format == "text") {
+    *request.output = stats_report(false);
+  } else if (request.format == "json") {
+    *request.output = stats_report(true);
+  } else {
+    m_log.warn("\"%s\" is not a valid stats format", request.format);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Formats the performance counters of the main loop and of all modules
+ */
+string controller::stats_report(bool json) const {
+  const auto& render = m_bar->stats();
+
+  if (json) {
+    string report = "{\"pid\":" + to_string(getpid());
+    report += ",\"frame\":{\"process_update\":" + perf_util::to_json(m_update_time);
+    report += ",\"parse\":" + perf_util::to_json(render.parse);
+    report += ",\"render\":" + perf_util::to_json(render.render);
+    report += "},\"modules\":[";
+
+    for (size_t i = 0; i < m_modules.size(); i++) {
+      const auto& module = m_modules[i];
+      const auto& stats = module->stats();
+
+      if (i > 0) {
+        report += ",";
+      }
+
+      report += "{\"name\":\"" + perf_util::json_escape(module->name_raw()) + "\"";
+      report += ",\"type\":\"" + perf_util::json_escape(module->type()) + "\"";
+      report += ",\"broadcasts\":" + to_string(stats.broadcasts.load());
+      report += ",\"suppressed\":" + to_string(stats.suppressed.load());
+      report += ",\"output_size\":" + to_string(stats.output_size.load());
+      report += ",\"update\":" + perf_util::to_json(stats.update);
+      report += ",\"output\":" + perf_util::to_json(stats.output) + "}";
+    }
+
+    return report + "]}";
+  }
+
+  string report = "PID " + to_string(getpid()) + "\n\n";
+  report += perf_util::text_header("frame") + "\n";
+  report += perf_util::to_text("process_update", m_update_time) + "\n";
+  report += perf_util::to_text("parse", render.parse) + "\n";
+  report += perf_util::to_text("render", render.render) + "\n\n";
+
+  report += perf_util::text_header("module") + "\n";
+  for (const auto& module : m_modules) {
+    report += perf_util::to_text(module->name_raw() + " update", module->stats().update) + "\n";
+    report += perf_util::to_text(module->name_raw() + " output", module->stats().output) + "\n";
+  }
+
+  char line[256];
+  snprintf(line, sizeof(line), "\n%-24s %10s %10s %10s", "module", "broadcasts", "suppressed", "output(B)");
+  report += line;
+
+  for (const auto& module : m_modules) {
+    const auto& stats = module->stats();
+    snprintf(line, sizeof(line), "\n%-24s %10zu %10zu %10zu", module->name_raw().c_str(), stats.broadcasts.load(),
+        stats.suppressed.load(), stats.output_size.load());
+    report += line;
+  }
+
+  return report;
+}
+
 bool controller::on(const signals::ui::update_background&) {
   trigger_update(true);
   return false;
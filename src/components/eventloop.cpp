@@ -102,6 +102,10 @@ namespace eventloop {
     UV(uv_signal_start, get(), event_cb<SignalEvent, &SignalHandle::callback>, signum);
   }
 
+  void SignalHandle::stop() {
+    UV(uv_signal_stop, get());
+  }
+
   void SignalHandle::reset_callbacks() {
     callback = nullptr;
   }
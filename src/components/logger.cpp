@@ -1,7 +1,12 @@
 #include "components/logger.hpp"
 
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
 #include "errors.hpp"
 #include "settings.hpp"
 #include "utils/concurrency.hpp"
@@ -39,33 +44,35 @@ logger::make_type logger::make(loglevel level) {
  * Construct logger
  */
 logger::logger(loglevel level) : m_level(level) {
+  auto set = [this](loglevel l, string prefix, string suffix) {
+    m_prefixes[to_integral(l)] = move(prefix);
+    m_suffixes[to_integral(l)] = move(suffix) + "\n";
+  };
+
   // clang-format off
   if (isatty(m_fd)) {
-    m_prefixes[loglevel::TRACE]   = "\r\033[0;32m- \033[0m";
-    m_prefixes[loglevel::INFO]    = "\r\033[1;32m* \033[0m";
-    m_prefixes[loglevel::NOTICE]  = "\r\033[1;34mnotice: \033[0m";
-    m_prefixes[loglevel::WARNING] = "\r\033[1;33mwarn: \033[0m";
-    m_prefixes[loglevel::ERROR]   = "\r\033[1;31merror: \033[0m";
-    m_suffixes[loglevel::TRACE]   = "\033[0m";
-    m_suffixes[loglevel::INFO]    = "\033[0m";
-    m_suffixes[loglevel::NOTICE]  = "\033[0m";
-    m_suffixes[loglevel::WARNING] = "\033[0m";
-    m_suffixes[loglevel::ERROR]   = "\033[0m";
+    set(loglevel::TRACE,   "\r\033[0;32m- \033[0m",        "\033[0m");
+    set(loglevel::INFO,    "\r\033[1;32m* \033[0m",        "\033[0m");
+    set(loglevel::NOTICE,  "\r\033[1;34mnotice: \033[0m",  "\033[0m");
+    set(loglevel::WARNING, "\r\033[1;33mwarn: \033[0m",    "\033[0m");
+    set(loglevel::ERROR,   "\r\033[1;31merror: \033[0m",   "\033[0m");
   } else {
-    m_prefixes.emplace(make_pair(loglevel::TRACE,   "polybar|trace: "));
-    m_prefixes.emplace(make_pair(loglevel::INFO,    "polybar|info:  "));
-    m_prefixes.emplace(make_pair(loglevel::NOTICE,  "polybar|notice:  "));
-    m_prefixes.emplace(make_pair(loglevel::WARNING, "polybar|warn:  "));
-    m_prefixes.emplace(make_pair(loglevel::ERROR,   "polybar|error: "));
-    m_suffixes.emplace(make_pair(loglevel::TRACE,   ""));
-    m_suffixes.emplace(make_pair(loglevel::INFO,    ""));
-    m_suffixes.emplace(make_pair(loglevel::NOTICE,  ""));
-    m_suffixes.emplace(make_pair(loglevel::WARNING, ""));
-    m_suffixes.emplace(make_pair(loglevel::ERROR,   ""));
+    set(loglevel::TRACE,   "polybar|trace: ",   "");
+    set(loglevel::INFO,    "polybar|info:  ",   "");
+    set(loglevel::NOTICE,  "polybar|notice:  ", "");
+    set(loglevel::WARNING, "polybar|warn:  ",   "");
+    set(loglevel::ERROR,   "polybar|error: ",   "");
   }
   // clang-format on
 }
 
+/**
+ * Flush buffered messages and stop the flusher thread
+ */
+logger::~logger() {
+  async(false);
+}
+
 /**
  * Set output verbosity
  */
@@ -97,4 +104,135 @@ loglevel logger::parse_verbosity(const string& name, loglevel fallback) {
   }
 }
 
+/**
+ * Enable or disable asynchronous output
+ *
+ * In asynchronous mode, messages are formatted by the calling thread and
+ * queued. A background thread periodically writes all queued lines in a
+ * single write. If the queue is full, messages are dropped and the number of
+ * dropped messages is reported with the next batch.
+ *
+ * Disabling asynchronous mode writes all pending messages before returning.
+ */
+void logger::async(bool enabled) {
+  if (enabled == m_async) {
+    return;
+  }
+
+  if (enabled) {
+    if (!m_queue) {
+      m_queue = make_unique<mpsc_ring_buffer<line>>(QUEUE_SIZE);
+    }
+
+    m_flush_stop = false;
+    m_async = true;
+    m_flusher = std::thread(&logger::flush_loop, this);
+  } else {
+    m_async = false;
+
+    {
+      std::lock_guard<std::mutex> guard(m_flush_mutex);
+      m_flush_stop = true;
+    }
+
+    m_flush_cv.notify_one();
+    m_flusher.join();
+
+    // Catch lines from producers that were still pushing when the flusher exited
+    string batch;
+    flush_queue(batch);
+  }
+}
+
+/**
+ * Number of messages dropped because the queue was full
+ */
+size_t logger::dropped() const {
+  return m_dropped;
+}
+
+/**
+ * Write a formatted message, either directly or through the queue
+ */
+void logger::write(loglevel level, const char* message, size_t length) const {
+  const string& prefix = m_prefixes[to_integral(level)];
+  const string& suffix = m_suffixes[to_integral(level)];
+
+  if (!m_async) {
+    iovec iov[3]{
+        {const_cast<char*>(prefix.data()), prefix.size()},
+        {const_cast<char*>(message), length},
+        {const_cast<char*>(suffix.data()), suffix.size()},
+    };
+    writev(m_fd, iov, 3);
+    return;
+  }
+
+  bool queued = m_queue->try_push([&](line& l) {
+    size_t size = std::min(length, LINE_SIZE - prefix.size() - suffix.size());
+    char* out = l.data;
+    out = std::copy_n(prefix.data(), prefix.size(), out);
+    out = std::copy_n(message, size, out);
+    out = std::copy_n(suffix.data(), suffix.size(), out);
+    l.size = out - l.data;
+  });
+
+  if (!queued) {
+    m_dropped++;
+  }
+}
+
+/**
+ * Flusher thread, writes queued lines until asynchronous mode is disabled
+ */
+void logger::flush_loop() {
+  string batch;
+  batch.reserve(QUEUE_SIZE * 128);
+
+  std::unique_lock<std::mutex> guard(m_flush_mutex);
+  bool stop = false;
+
+  while (!stop) {
+    stop = m_flush_cv.wait_for(guard, 25ms, [this] { return m_flush_stop; });
+    guard.unlock();
+    flush_queue(batch);
+    guard.lock();
+  }
+}
+
+/**
+ * Write all queued lines, followed by a warning about dropped messages
+ */
+void logger::flush_queue(string& batch) {
+  while (m_queue->try_pop([&](line& l) { batch.append(l.data, l.size); })) {
+  }
+
+  size_t dropped = m_dropped;
+  if (dropped != m_reported_dropped) {
+    batch += m_prefixes[to_integral(loglevel::WARNING)];
+    batch += "Log buffer full, dropped " + to_string(dropped - m_reported_dropped) + " message(s)";
+    batch += m_suffixes[to_integral(loglevel::WARNING)];
+    m_reported_dropped = dropped;
+  }
+
+  write_fd(batch.data(), batch.size());
+  batch.clear();
+}
+
+void logger::write_fd(const char* data, size_t length) const {
+  while (length > 0) {
+    ssize_t written = ::write(m_fd, data, length);
+
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    data += written;
+    length -= written;
+  }
+}
+
 POLYBAR_NS_END
@@ -8,6 +8,8 @@
 #include "events/signal_emitter.hpp"
 #include "events/signal_receiver.hpp"
 #include "utils/math.hpp"
+#include "utils/time.hpp"
+#include "utils/trace.hpp"
 #include "utils/units.hpp"
 #include "x11/atoms.hpp"
 #include "x11/background_manager.hpp"
@@ -115,6 +117,8 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
 
   m_log.trace("renderer: Load fonts");
   {
+    time_util::stopwatch timer;
+    auto cache = make_shared<cairo::font_cache>(cairo::font_cache::default_path(), cairo::fontconfig_generation());
     auto fonts = m_conf.get_list<string>(m_conf.section(), "font", {});
     if (fonts.empty()) {
       m_log.warn("No fonts specified, using fallback font \"fixed\"");
@@ -129,10 +133,10 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
         offset = std::strtol(pattern.substr(pos + 1).c_str(), nullptr, 10);
         pattern.erase(pos);
       }
-      auto font = cairo::make_font(*m_context, string{pattern}, offset, m_bar.dpi_x, m_bar.dpi_y);
-      m_log.notice("Loaded font \"%s\" (name=%s, offset=%i, file=%s)", pattern, font->name(), offset, font->file());
-      *m_context << move(font);
+      *m_context << cairo::make_font(*m_context, string{pattern}, offset, m_bar.dpi_x, m_bar.dpi_y, cache);
     }
+
+    m_log.info("Startup: Loading %zu font(s) took %lu ms", fonts.size(), timer.elapsed());
   }
 
   m_pseudo_transparency = m_conf.get<bool>("settings", "pseudo-transparency", m_pseudo_transparency);
@@ -299,6 +303,9 @@ void renderer::flush(alignment a) {
     return;
   }
 
+  static constexpr const char* span_names[]{"flush", "flush left", "flush center", "flush right"};
+  trace_util::span span(span_names[static_cast<int>(a)]);
+
   m_context->save();
 
   double x = static_cast<int>(block_x(a) + 0.5);
@@ -364,9 +371,12 @@ void renderer::flush() {
   highlight_clickable_areas();
 
   m_surface->flush();
-  // Copy pixmap onto the window
-  m_connection.copy_area(m_pixmap, m_window, m_gcontext, 0, 0, 0, 0, m_bar.size.w, m_bar.size.h);
-  m_connection.flush();
+  {
+    trace_util::span span("x flush");
+    // Copy pixmap onto the window
+    m_connection.copy_area(m_pixmap, m_window, m_gcontext, 0, 0, 0, 0, m_bar.size.w, m_bar.size.h);
+    m_connection.flush();
+  }
 
   if (!m_snapshot_dst.empty()) {
     try {
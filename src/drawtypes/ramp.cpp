@@ -36,9 +36,7 @@ namespace drawtypes {
     } else if (value >= max) {
       index = m_icons.size() - 1;
     } else {
-      float percentage = math_util::percentage(value, min, max);
-      index = percentage * (m_icons.size() - 2) / 100.0f + 1;
-      index = math_util::cap<size_t>(index, 0, m_icons.size() - 1);
+      index = index_by_percentage_with_borders(math_util::percentage(value, min, max));
     }
     return m_icons[index];
   }
@@ -47,6 +45,37 @@ namespace drawtypes {
     return !m_icons.empty();
   }
 
+  /**
+   * Index for a value strictly between the borders, `percentage` is the rounded
+   * percentage of the value between them
+   */
+  size_t ramp::index_by_percentage_with_borders(int percentage) const {
+    size_t index = static_cast<float>(percentage) * (m_icons.size() - 2) / 100.0f + 1;
+    return math_util::cap<size_t>(index, 0, m_icons.size() - 1);
+  }
+
+  ramp_table::ramp_table(const ramp& r, float min, float max) : m_min(min), m_max(max) {
+    m_labels.reserve(102);
+    m_labels.emplace_back(r.m_icons[0]);
+
+    /*
+     * Values at or above `max` use the last label, which is the same as the
+     * one for 100%
+     */
+    for (int percentage = 0; percentage <= 100; percentage++) {
+      m_labels.emplace_back(r.m_icons[r.index_by_percentage_with_borders(percentage)]);
+    }
+  }
+
+  const label_t& ramp_table::get(float value) const {
+    if (value <= m_min) {
+      return m_labels[0];
+    } else if (value >= m_max) {
+      return m_labels.back();
+    }
+    return m_labels[1 + math_util::percentage(value, m_min, m_max)];
+  }
+
   /**
    * Create a ramp by loading values
    * from the configuration
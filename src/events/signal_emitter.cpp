@@ -1,9 +1,85 @@
 #include "events/signal_emitter.hpp"
+
+#include <algorithm>
+#include <thread>
+
 #include "utils/factory.hpp"
 
 POLYBAR_NS
 
-signal_receivers_t g_signal_receivers;
+std::mutex g_signal_update_lock;
+
+/**
+ * Emit state of all threads that ever emitted a signal
+ */
+static vector<shared_ptr<detail::emit_slot>> g_emit_slots;
+static std::mutex g_emit_slots_lock;
+
+/**
+ * Receiver lists that were replaced but may still be read by an emit
+ */
+static vector<unique_ptr<const detail::receiver_list_base>> g_retired_receivers;
+static std::mutex g_retired_lock;
+
+namespace {
+  /**
+   * Registers the emit state of a thread for as long as the thread exists
+   */
+  struct emit_slot_registration {
+    emit_slot_registration() : slot(make_shared<detail::emit_slot>()) {
+      std::lock_guard<std::mutex> guard(g_emit_slots_lock);
+      g_emit_slots.push_back(slot);
+    }
+
+    ~emit_slot_registration() {
+      std::lock_guard<std::mutex> guard(g_emit_slots_lock);
+      g_emit_slots.erase(std::find(g_emit_slots.begin(), g_emit_slots.end(), slot));
+    }
+
+    shared_ptr<detail::emit_slot> slot;
+  };
+
+  /**
+   * Waits until every emit that was running in another thread when this was
+   * called has returned.
+   *
+   * If `self` is inside an emit, threads that wait from within an emit as
+   * well are skipped, otherwise two such threads would wait for each other
+   * forever.
+   */
+  void synchronize(detail::emit_slot& self) {
+    vector<shared_ptr<detail::emit_slot>> slots;
+    {
+      std::lock_guard<std::mutex> guard(g_emit_slots_lock);
+      slots = g_emit_slots;
+    }
+
+    bool nested = self.depth > 0;
+    if (nested) {
+      self.waiting = true;
+    }
+
+    for (const auto& slot : slots) {
+      if (slot.get() == &self) {
+        continue;
+      }
+
+      uint64_t sequence = slot->sequence.load();
+      while (sequence % 2 == 1 && slot->sequence.load() == sequence && !(nested && slot->waiting.load())) {
+        std::this_thread::yield();
+      }
+    }
+
+    if (nested) {
+      self.waiting = false;
+    }
+  }
+} // namespace
+
+detail::emit_slot& detail::current_emit_slot() {
+  thread_local emit_slot_registration registration;
+  return *registration.slot;
+}
 
 /**
  * Create instance
@@ -12,4 +88,29 @@ signal_emitter::make_type signal_emitter::make() {
   return static_cast<signal_emitter&>(*factory_util::singleton<signal_emitter>());
 }
 
+void signal_emitter::retire(const detail::receiver_list_base* list) {
+  auto& self = detail::current_emit_slot();
+  vector<unique_ptr<const detail::receiver_list_base>> expired;
+
+  {
+    std::lock_guard<std::mutex> guard(g_retired_lock);
+    if (list != nullptr) {
+      g_retired_receivers.emplace_back(list);
+    }
+    expired.swap(g_retired_receivers);
+  }
+
+  /*
+   * All of these lists were replaced before this point, so only emits that
+   * are already running can still read them.
+   */
+  synchronize(self);
+
+  // The emit this was called from may still iterate one of the lists
+  if (self.depth > 0) {
+    std::lock_guard<std::mutex> guard(g_retired_lock);
+    std::move(expired.begin(), expired.end(), std::back_inserter(g_retired_receivers));
+  }
+}
+
 POLYBAR_NS_END
@@ -15,6 +15,7 @@
 #include "utils/env.hpp"
 #include "utils/file.hpp"
 #include "utils/string.hpp"
+#include "utils/trace.hpp"
 
 POLYBAR_NS
 
@@ -88,6 +89,9 @@ namespace ipc {
       case v0::ipc_type::ACTION:
         m_log.info("Received ipc action: '%s'", msg);
         return m_sig.emit(signals::ipc::action{msg});
+      case v0::ipc_type::STATS:
+        // Stats requests need a response payload and are handled in on_connection
+        break;
     }
 
     assert(false);
@@ -110,6 +114,7 @@ namespace ipc {
   void ipc::on_connection() {
     auto connection = make_unique<ipc::connection>(
         m_loop, [this](ipc::connection& c, uint8_t, type_t type, const vector<uint8_t>& msg) {
+          trace_util::span span("ipc message");
           vector<uint8_t> response;
 
           if (type == to_integral(v0::ipc_type::ACTION) || type == to_integral(v0::ipc_type::CMD)) {
@@ -121,6 +126,15 @@ namespace ipc {
             } else {
               response = encode(TYPE_ERR, "Error while executing ipc message, see polybar log for details.");
             }
+          } else if (type == to_integral(v0::ipc_type::STATS)) {
+            string format(msg.begin(), msg.end());
+            string report;
+            m_log.info("Received ipc stats request (format: '%s')", format);
+            if (m_sig.emit(signals::ipc::stats{signals::ipc::stats_request{format, &report}})) {
+              response = encode(TYPE_OK, report);
+            } else {
+              response = encode(TYPE_ERR, "Unsupported stats format '" + format + "', use 'text' or 'json'");
+            }
           } else {
             response = encode(TYPE_ERR, "Unrecognized IPC message type " + to_string(type));
           }
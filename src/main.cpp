@@ -6,7 +6,10 @@
 #include "ipc/ipc.hpp"
 #include "utils/env.hpp"
 #include "utils/inotify.hpp"
+#include "utils/launcher.hpp"
 #include "utils/process.hpp"
+#include "utils/time.hpp"
+#include "utils/trace.hpp"
 #include "x11/connection.hpp"
 
 using namespace polybar;
@@ -19,6 +22,7 @@ int main(int argc, char** argv) {
       command_line::option{"-v", "--version", "Display build details and exit"},
       command_line::option{"-l", "--log", "Set the logging verbosity (default: notice)", "LEVEL", {"error", "warning", "notice", "info", "trace"}},
       command_line::option{"-q", "--quiet", "Be quiet (will override -l)"},
+      command_line::option{"-a", "--log-async", "Buffer log messages and write them from a background thread"},
       command_line::option{"-c", "--config", "Path to the configuration file", "FILE"},
       command_line::option{"-r", "--reload", "Reload when the configuration has been modified"},
       command_line::option{"-d", "--dump", "Print value of PARAM in bar section and exit", "PARAM"},
@@ -27,6 +31,7 @@ int main(int argc, char** argv) {
       command_line::option{"-w", "--print-wmname", "Print the generated WM_NAME and exit"},
       command_line::option{"-s", "--stdout", "Output data to stdout instead of drawing it to the X window"},
       command_line::option{"-p", "--png", "Save png snapshot to FILE after running for 3 seconds", "FILE"},
+      command_line::option{"-t", "--trace", "Record trace events and write them to FILE on exit", "FILE"},
   };
   // clang-format on
 
@@ -51,6 +56,10 @@ int main(int argc, char** argv) {
       logger.verbosity(logger::parse_verbosity(cli->get("log")));
     }
 
+    if (cli->has("trace")) {
+      trace_util::start(cli->get("trace"));
+    }
+
     if (cli->has("help")) {
       cli->usage();
       return EXIT_SUCCESS;
@@ -127,8 +136,10 @@ int main(int argc, char** argv) {
       barname = cli->get(0);
     }
 
+    time_util::stopwatch parse_timer;
     config_parser parser{logger, move(confpath)};
     config conf = parser.parse(move(barname));
+    logger.info("Startup: Parsing config took %lu ms", parse_timer.elapsed());
 
     //==================================================
     // Dump requested data
@@ -142,6 +153,23 @@ int main(int argc, char** argv) {
       return EXIT_SUCCESS;
     }
 
+    //==================================================
+    // Fork the launcher while there is only one thread
+    //==================================================
+    unique_ptr<launcher> click_launcher{};
+
+    if (conf.get("settings", "click-launcher", false)) {
+      try {
+        click_launcher = make_unique<launcher>();
+      } catch (const std::exception& e) {
+        logger.err("Disabling the click launcher due to error: %s", e.what());
+      }
+    }
+
+    if (cli->has("log-async")) {
+      logger.async(true);
+    }
+
     //==================================================
     // Create controller and run application
     //==================================================
@@ -156,11 +184,16 @@ int main(int argc, char** argv) {
       }
     }
 
-    auto ctrl = controller::make((bool)ipc, loop, conf);
+    auto ctrl = controller::make((bool)ipc, loop, conf, click_launcher.get());
 
     if (!ctrl->run(cli->has("stdout"), cli->get("png"), cli->has("reload"))) {
       reload = true;
     }
+
+    // End and reap the launcher before polybar executes itself again, the new
+    // instance forks its own
+    ctrl.reset();
+    click_launcher.reset();
   } catch (const exception& err) {
     logger.err("Uncaught exception, shutting down: %s", err.what());
     exit_code = EXIT_FAILURE;
@@ -171,8 +204,17 @@ int main(int argc, char** argv) {
     ;
   }
 
+  if (trace_util::enabled()) {
+    try {
+      logger.notice("Wrote trace events to '%s'", trace_util::dump());
+    } catch (const std::system_error& err) {
+      logger.err("Failed to write trace events (%s)", err.what());
+    }
+  }
+
   if (reload) {
     logger.info("Re-launching application...");
+    logger.async(false);
     process_util::exec(move(argv[0]), move(argv));
   }
 
@@ -1,5 +1,12 @@
 #include "modules/battery.hpp"
 
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <utility>
+
 #include "drawtypes/animation.hpp"
 #include "drawtypes/label.hpp"
 #include "drawtypes/progressbar.hpp"
@@ -14,101 +21,61 @@ POLYBAR_NS
 namespace modules {
   template class module<battery_module>;
 
-  template <typename ValueReader>
-  typename ValueReader::return_type read(ValueReader& reader) {
-    std::lock_guard<ValueReader> guard(reader);
-    return reader.read();
-  }
-
   /**
    * Bootstrap module by setting up required components
    */
   battery_module::battery_module(const bar_settings& bar, string name_, const config& config)
-      : inotify_module<battery_module>(bar, move(name_), config) {
+      : event_module<battery_module>(bar, move(name_), config) {
     // Load configuration values
     m_fullat = std::min(m_conf.get(name(), "full-at", m_fullat), 100);
     m_lowat = std::max(m_conf.get(name(), "low-at", m_lowat), 0);
     m_interval = m_conf.get<decltype(m_interval)>(name(), "poll-interval", 5s);
     m_lastpoll = chrono::steady_clock::now();
 
-    auto path_adapter = string_util::replace(PATH_ADAPTER, "%adapter%", m_conf.get(name(), "adapter", "ADP1"s)) + "/";
-    auto path_battery = string_util::replace(PATH_BATTERY, "%battery%", m_conf.get(name(), "battery", "BAT0"s)) + "/";
+    m_adapter_name = m_conf.get(name(), "adapter", "ADP1"s);
+    m_battery_name = m_conf.get(name(), "battery", "BAT0"s);
+    auto path_adapter = string_util::replace(PATH_ADAPTER, "%adapter%", m_adapter_name) + "/";
+    auto path_battery = string_util::replace(PATH_BATTERY, "%battery%", m_battery_name) + "/";
 
-    // Make state reader
+    // Find the file for the charge state
     if (file_util::exists((m_fstate = path_battery + "status"))) {
-      m_state_reader =
-          make_unique<state_reader>([=] { return file_util::contents(m_fstate).compare(0, 8, "Charging") == 0; });
+      m_state_from_status = true;
     } else if (file_util::exists((m_fstate = path_adapter + "online"))) {
-      m_state_reader = make_unique<state_reader>([=] { return file_util::contents(m_fstate).compare(0, 1, "1") == 0; });
+      m_state_from_status = false;
     } else {
       throw module_error("No suitable way to get current charge state");
     }
 
-    // Make capacity reader
+    // Find the capacity files
     if ((m_fcapnow = file_util::pick({path_battery + "charge_now", path_battery + "energy_now"})).empty()) {
       throw module_error("No suitable way to get current capacity value");
     } else if ((m_fcapfull = file_util::pick({path_battery + "charge_full", path_battery + "energy_full"})).empty()) {
       throw module_error("No suitable way to get max capacity value");
     }
 
-    m_capacity_reader = make_unique<capacity_reader>([=] {
-      auto cap_now = std::strtoul(file_util::contents(m_fcapnow).c_str(), nullptr, 10);
-      auto cap_max = std::strtoul(file_util::contents(m_fcapfull).c_str(), nullptr, 10);
-      return math_util::percentage(cap_now, 0UL, cap_max);
-    });
-
-    // Make rate reader
+    // Find the rate files
     if ((m_fvoltage = file_util::pick({path_battery + "voltage_now"})).empty()) {
       throw module_error("No suitable way to get current voltage value");
     } else if ((m_frate = file_util::pick({path_battery + "current_now", path_battery + "power_now"})).empty()) {
       throw module_error("No suitable way to get current charge rate value");
     }
 
-    m_rate_reader = make_unique<rate_reader>([this] {
-      unsigned long rate{static_cast<unsigned long>(std::abs(std::strtol(file_util::contents(m_frate).c_str(), nullptr, 10)))};
-      unsigned long volt{std::strtoul(file_util::contents(m_fvoltage).c_str(), nullptr, 10) / 1000UL};
-      unsigned long now{std::strtoul(file_util::contents(m_fcapnow).c_str(), nullptr, 10)};
-      unsigned long max{std::strtoul(file_util::contents(m_fcapfull).c_str(), nullptr, 10)};
-      unsigned long cap{read(*m_state_reader) ? max - now : now};
-
-      if (rate && volt && cap) {
-        auto remaining = (cap / volt);
-        auto current_rate = (rate / volt);
-
-        if (remaining && current_rate) {
-          return 3600UL * remaining / current_rate;
-        }
-      }
-
-      return 0UL;
-    });
-
-    // Make consumption reader
-    m_consumption_reader = make_unique<consumption_reader>([this] {
-      float consumption;
-
-      // if the rate we found was the current, calculate power (P = I*V)
-      if (string_util::contains(m_frate, "current_now")) {
-        unsigned long current{std::strtoul(file_util::contents(m_frate).c_str(), nullptr, 10)};
-        unsigned long voltage{std::strtoul(file_util::contents(m_fvoltage).c_str(), nullptr, 10)};
-
-        consumption = ((voltage / 1000.0) * (current / 1000.0)) / 1e6;
-      } else {
-        // if it was power, just use as is
-        unsigned long power{std::strtoul(file_util::contents(m_frate).c_str(), nullptr, 10)};
-
-        consumption = power / 1e6;
+    m_state_file = make_unique<proc_file>(m_fstate);
+    m_capnow_file = make_unique<proc_file>(m_fcapnow);
+    m_capfull_file = make_unique<proc_file>(m_fcapfull);
+    m_rate_file = make_unique<proc_file>(m_frate);
+    m_voltage_file = make_unique<proc_file>(m_fvoltage);
+
+    if (!open_uevent_socket()) {
+      m_log.warn("%s: Failed to subscribe to power supply uevents, only polling every %.2fs", name(),
+          m_interval.count() > 0 ? m_interval.count() : 5.0);
+      if (m_interval.count() <= 0) {
+        m_interval = 5s;
       }
-
-      // convert to string with 2 decimmal places
-      string rtn(16, '\0'); // 16 should be plenty big. Cant see it needing more than 6/7..
-      auto written = std::snprintf(&rtn[0], rtn.size(), "%.2f", consumption);
-      rtn.resize(written);
-
-      return rtn;
-    });
+    }
 
     // Load state and capacity level
+    read_snapshot();
     m_state = current_state();
     m_percentage = current_percentage();
 
@@ -151,10 +118,6 @@ namespace modules {
       m_label_full = load_optional_label(m_conf, name(), TAG_LABEL_FULL, "%percentage%%");
     }
 
-    // Create inotify watches
-    watch(m_fcapnow, IN_ACCESS);
-    watch(m_fstate, IN_ACCESS);
-
     // Setup time if token is used
     if ((m_label_charging && m_label_charging->has_token("%time%")) ||
         (m_label_discharging && m_label_discharging->has_token("%time%")) ||
@@ -169,68 +132,101 @@ namespace modules {
   /**
    * Dispatch the subthread used to update the
    * charging animation when the module is started
+   *
+   * It is joined by join(), after stop() released the locks its broadcasts
+   * need.
    */
   void battery_module::start() {
-    this->inotify_module::start();
+    this->event_module::start();
     // We only start animation thread if there is at least one animation.
     if (m_animation_charging || m_animation_discharging || m_animation_low) {
-      m_subthread = thread(&battery_module::subthread, this);
+      m_threads.emplace_back(thread(&battery_module::subthread, this));
     }
   }
 
   /**
-   * Release wake lock when stopping the module
-   */
-  void battery_module::teardown() {
-    if (m_subthread.joinable()) {
-      m_subthread.join();
-    }
-  }
-
-  /**
-   * Idle between polling inotify watches for events.
+   * Wait for a power supply uevent or until the poll interval elapsed
    *
-   * If the defined interval has been reached, trigger a manual
-   * poll in case the inotify events aren't fired.
+   * Not every driver sends uevents when the capacity changes, some only do
+   * for changes of the charge state. Polling covers those, set
+   * `poll-interval` to 0 to rely on uevents alone.
    *
-   * This fallback is needed because some systems won't
-   * report inotify events for files on sysfs.
+   * Runs without the update lock, so stop() doesn't have to wait for it.
    */
   void battery_module::idle() {
-    if (m_interval.count() > 0) {
-      auto now = chrono::steady_clock::now();
-      if (chrono::duration_cast<decltype(m_interval)>(now - m_lastpoll) > m_interval) {
-        m_lastpoll = now;
-        m_log.info("%s: Polling values (inotify fallback)", name());
-        on_event({});
+    while (running() && !m_changed) {
+      struct pollfd fds[] = {
+          {m_wakeup.fd(), POLLIN, 0},
+          {m_uevent_fd ? static_cast<int>(*m_uevent_fd) : -1, POLLIN, 0},
+      };
+
+      int timeout = -1;
+      if (m_interval.count() > 0) {
+        auto remaining = m_lastpoll + chrono::duration_cast<chrono::steady_clock::duration>(m_interval) -
+                         chrono::steady_clock::now();
+        timeout = std::max(0L, static_cast<long>(chrono::duration_cast<chrono::milliseconds>(remaining).count()) + 1);
+      }
+
+      if (poll(fds, 2, timeout) == -1 && errno != EINTR) {
+        throw module_error("Failed to wait for power supply events (" + string(strerror(errno)) + ")");
+      }
+
+      // Notified by wakeup(), e.g. when the module is stopped
+      if (fds[0].revents & POLLIN) {
+        m_wakeup.drain();
+        return;
+      }
+
+      if (fds[1].revents & POLLIN) {
+        char buffer[8192];
+        struct sockaddr_nl sender {};
+        socklen_t sender_len = sizeof(sender);
+        ssize_t bytes;
+
+        while ((bytes = recvfrom(*m_uevent_fd, buffer, sizeof(buffer), 0, reinterpret_cast<struct sockaddr*>(&sender),
+                    &sender_len)) > 0) {
+          // Only trust the kernel
+          if (sender.nl_pid == 0 && is_power_supply_event(buffer, bytes)) {
+            m_changed = true;
+          }
+          sender_len = sizeof(sender);
+        }
+
+        // Events were dropped, they might have been ours
+        m_changed |= bytes == -1 && errno == ENOBUFS;
+      }
+
+      if (m_interval.count() > 0 && chrono::steady_clock::now() - m_lastpoll >= m_interval) {
+        m_log.trace("%s: Polling values", name());
+        m_changed = true;
       }
     }
+  }
 
-    this->inotify_module::idle();
+  void battery_module::wakeup() {
+    if (!m_wakeup.notify()) {
+      m_log.err("%s: Failed to wake up module (%s)", name(), strerror(errno));
+    }
+    module::wakeup();
   }
 
   /**
-   * Update values when tracked files have changed
+   * Whether idle() saw a power supply event or the poll interval elapsed
    */
-  bool battery_module::on_event(const inotify_event& event) {
-    auto state = current_state();
-    auto percentage = current_percentage();
+  bool battery_module::has_event() {
+    return std::exchange(m_changed, false);
+  }
 
+  /**
+   * Update values after an event or once the poll interval elapsed
+   */
+  bool battery_module::update() {
     // Reset timer to avoid unnecessary polling
     m_lastpoll = chrono::steady_clock::now();
 
-    if (event.is_valid) {
-      m_log.trace("%s: Inotify event reported for %s", name(), event.filename);
-
-      if (state == m_state && percentage == m_percentage && m_unchanged--) {
-        return false;
-      }
-
-      m_unchanged = SKIP_N_UNCHANGED;
-    }
-
-    m_state = state;
-    m_percentage = percentage;
+    read_snapshot();
+    m_state = current_state();
+    m_percentage = current_percentage();
 
     const auto replace_tokens = [&](label_t& label) {
       if (!label) {
@@ -305,14 +301,71 @@ namespace modules {
     return true;
   }
 
+  /**
+   * Reads every file once, all values of an update are computed from this
+   */
+  void battery_module::read_snapshot() {
+    if (m_state_from_status) {
+      m_snapshot.charging = m_state_file->read() && strncmp(m_state_file->data(), "Charging", 8) == 0;
+    } else {
+      m_snapshot.charging = m_state_file->read() && m_state_file->data()[0] == '1';
+    }
+
+    m_snapshot.capacity_now = static_cast<unsigned long>(m_capnow_file->read_number());
+    m_snapshot.capacity_full = static_cast<unsigned long>(m_capfull_file->read_number());
+    m_snapshot.rate = m_rate_file->read_number();
+    m_snapshot.voltage = static_cast<unsigned long>(m_voltage_file->read_number());
+  }
+
+  bool battery_module::open_uevent_socket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd == -1) {
+      return false;
+    }
+    m_uevent_fd = file_util::make_file_descriptor(fd);
+
+    // Group 1 receives the kernel events, udev rebroadcasts them on group 2
+    struct sockaddr_nl addr {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+      m_uevent_fd.reset();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Checks if the uevent concerns the battery or the adapter
+   *
+   * The message is `action@devpath` followed by `KEY=value` pairs, all null
+   * terminated.
+   */
+  bool battery_module::is_power_supply_event(const char* msg, size_t size) const {
+    bool power_supply = false;
+    bool ours = false;
+
+    for (const char* end = msg + size; msg < end; msg += strnlen(msg, end - msg) + 1) {
+      if (strcmp(msg, "SUBSYSTEM=power_supply") == 0) {
+        power_supply = true;
+      } else if (strncmp(msg, "POWER_SUPPLY_NAME=", 18) == 0) {
+        ours = m_battery_name == msg + 18 || m_adapter_name == msg + 18;
+      }
+    }
+
+    return power_supply && ours;
+  }
+
   /**
    * Get the current battery state
    */
-  battery_module::state battery_module::current_state() {
-    auto charge = read(*m_capacity_reader);
+  battery_module::state battery_module::current_state() const {
+    auto charge = current_percentage();
     if (charge >= m_fullat) {
       return battery_module::state::FULL;
-    } else if (!read(*m_state_reader)) {
+    } else if (!m_snapshot.charging) {
       return charge <= m_lowat ? battery_module::state::LOW : battery_module::state::DISCHARGING;
     } else {
       return battery_module::state::CHARGING;
@@ -322,8 +375,8 @@ namespace modules {
   /**
    * Get the current capacity level
    */
-  int battery_module::current_percentage() {
-    return read(*m_capacity_reader);
+  int battery_module::current_percentage() const {
+    return math_util::percentage(m_snapshot.capacity_now, 0UL, m_snapshot.capacity_full);
   }
 
   int battery_module::clamp_percentage(int percentage, state state) const {
@@ -336,19 +389,55 @@ namespace modules {
   /**
    * Get the current power consumption
    */
-  string battery_module::current_consumption() {
-    return read(*m_consumption_reader);
+  string battery_module::current_consumption() const {
+    float consumption;
+
+    // if the rate we found was the current, calculate power (P = I*V)
+    if (string_util::contains(m_frate, "current_now")) {
+      unsigned long current{static_cast<unsigned long>(m_snapshot.rate)};
+      unsigned long voltage{m_snapshot.voltage};
+
+      consumption = ((voltage / 1000.0) * (current / 1000.0)) / 1e6;
+    } else {
+      // if it was power, just use as is
+      unsigned long power{static_cast<unsigned long>(m_snapshot.rate)};
+
+      consumption = power / 1e6;
+    }
+
+    // convert to string with 2 decimmal places
+    string rtn(16, '\0'); // 16 should be plenty big. Cant see it needing more than 6/7..
+    auto written = std::snprintf(&rtn[0], rtn.size(), "%.2f", consumption);
+    rtn.resize(written);
+
+    return rtn;
   }
 
   /**
    * Get estimate of remaining time until fully dis-/charged
    */
-  string battery_module::current_time() {
+  string battery_module::current_time() const {
     struct tm t {
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, nullptr
     };
 
-    chrono::seconds sec{read(*m_rate_reader)};
+    unsigned long rate{static_cast<unsigned long>(std::abs(m_snapshot.rate))};
+    unsigned long volt{m_snapshot.voltage / 1000UL};
+    unsigned long now{m_snapshot.capacity_now};
+    unsigned long max{m_snapshot.capacity_full};
+    unsigned long cap{m_snapshot.charging ? max - now : now};
+    unsigned long seconds{0};
+
+    if (rate && volt && cap) {
+      auto remaining = (cap / volt);
+      auto current_rate = (rate / volt);
+
+      if (remaining && current_rate) {
+        seconds = 3600UL * remaining / current_rate;
+      }
+    }
+
+    chrono::seconds sec{seconds};
     if (sec.count() > 0) {
       t.tm_hour = chrono::duration_cast<chrono::hours>(sec).count();
       sec -= chrono::seconds{3600 * t.tm_hour};
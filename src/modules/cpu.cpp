@@ -1,7 +1,7 @@
 #include "modules/cpu.hpp"
 
-#include <fstream>
-#include <istream>
+#include <algorithm>
+#include <cstring>
 
 #include "drawtypes/label.hpp"
 #include "drawtypes/progressbar.hpp"
@@ -41,6 +41,7 @@ namespace modules {
     }
     if (m_formatter->has(TAG_RAMP_LOAD_PER_CORE)) {
       m_rampload_core = load_ramp(m_conf, name(), TAG_RAMP_LOAD_PER_CORE);
+      m_rampload_core_table = ramp_table(*m_rampload_core, 0.0f, m_totalwarn);
     }
   }
 
@@ -49,27 +50,48 @@ namespace modules {
       return false;
     }
 
-    m_total = 0.0f;
-    m_load.clear();
-
-    auto cores_n = m_cputimes.size();
+    auto cores_n = m_samples.total.size();
     if (!cores_n) {
+      m_total = 0.0f;
+      m_load.clear();
       return false;
     }
 
-    vector<string> percentage_cores;
-    for (size_t i = 0; i < cores_n; i++) {
-      auto load = get_load(i);
-      m_total += load;
-      m_load.emplace_back(load);
+    /*
+     * Cores that only appeared since the last read (e.g. after being brought
+     * online) have no load yet
+     */
+    auto n = std::min(cores_n, m_samples_prev.total.size());
+    m_load.assign(cores_n, 0.0f);
+
+    const auto* idle = m_samples.idle.data();
+    const auto* idle_prev = m_samples_prev.idle.data();
+    const auto* total = m_samples.total.data();
+    const auto* total_prev = m_samples_prev.total.data();
+    auto* load = m_load.data();
+
+    // Kept free of branches and calls so that the compiler can vectorize it
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+      float diff = static_cast<float>(total[i] - total_prev[i]);
+      float busy = diff - static_cast<float>(idle[i] - idle_prev[i]);
+      float value = diff > 0.0f ? 100.0f * busy / diff : 0.0f;
+      value = value < 0.0f ? 0.0f : value;
+      value = value > 100.0f ? 100.0f : value;
+      load[i] = value;
+      sum += value;
+    }
 
-      if (m_label || m_labelwarn) {
-        percentage_cores.emplace_back(to_string(static_cast<int>(load + 0.5)));
+    m_total = sum / static_cast<float>(cores_n);
+
+    vector<string> percentage_cores;
+    if (m_label || m_labelwarn) {
+      percentage_cores.reserve(cores_n);
+      for (auto value : m_load) {
+        percentage_cores.emplace_back(to_string(static_cast<int>(value + 0.5)));
       }
     }
 
-    m_total = m_total / static_cast<float>(cores_n);
-
     const auto replace_tokens = [&](label_t& label) {
       label->reset_tokens();
       label->replace_token("%percentage%", to_string(static_cast<int>(m_total + 0.5)));
@@ -115,7 +137,7 @@ namespace modules {
         if (i++ > 0) {
           builder->spacing(m_ramp_padding);
         }
-        builder->node(m_rampload_core->get_by_percentage_with_borders(load, 0.0f, m_totalwarn));
+        builder->node(m_rampload_core_table.get(load));
       }
       builder->node(builder->flush());
     } else {
@@ -125,59 +147,54 @@ namespace modules {
   }
 
   bool cpu_module::read_values() {
-    m_cputimes_prev.swap(m_cputimes);
-    m_cputimes.clear();
-
-    try {
-      std::ifstream in(PATH_CPU_INFO);
-      string str;
+    // Reuses the arrays of the previous read to avoid allocating
+    std::swap(m_samples_prev, m_samples);
+    m_samples.idle.clear();
+    m_samples.total.clear();
 
-      while (std::getline(in, str) && str.compare(0, 3, "cpu") == 0) {
-        // skip line with accumulated value
-        if (str.compare(0, 4, "cpu ") == 0) {
-          continue;
-        }
+    if (!m_stat.read()) {
+      m_log.err("Failed to read CPU values from %s", m_stat.path());
+      return false;
+    }
 
-        auto values = string_util::split(str, ' ');
+    const char* pos = m_stat.data();
+    const char* end = pos + m_stat.size();
 
-        m_cputimes.emplace_back(new cpu_time);
-        m_cputimes.back()->user = std::stoull(values[1], nullptr, 10);
-        m_cputimes.back()->nice = std::stoull(values[2], nullptr, 10);
-        m_cputimes.back()->system = std::stoull(values[3], nullptr, 10);
-        m_cputimes.back()->idle = std::stoull(values[4], nullptr, 10);
-        m_cputimes.back()->steal = std::stoull(values[8], nullptr, 10);
-        m_cputimes.back()->total = m_cputimes.back()->user + m_cputimes.back()->nice + m_cputimes.back()->system +
-                                   m_cputimes.back()->idle + m_cputimes.back()->steal;
+    while (pos < end && strncmp(pos, "cpu", 3) == 0) {
+      auto eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (eol == nullptr) {
+        eol = end;
       }
-    } catch (const std::ios_base::failure& e) {
-      m_log.err("Failed to read CPU values (what: %s)", e.what());
-    }
-
-    return !m_cputimes.empty();
-  }
 
-  float cpu_module::get_load(size_t core) const {
-    if (m_cputimes.empty() || m_cputimes_prev.empty()) {
-      return 0;
-    } else if (core >= m_cputimes.size() || core >= m_cputimes_prev.size()) {
-      return 0;
-    }
+      // skip line with accumulated value
+      if (pos[3] != ' ') {
+        pos += 3;
+        while (pos < eol && *pos != ' ') {
+          pos++;
+        }
 
-    auto& last = m_cputimes[core];
-    auto& prev = m_cputimes_prev[core];
+        // user nice system idle iowait irq softirq steal
+        unsigned long long values[8]{};
+        size_t count = 0;
+        while (count < 8 && file_util::parse_number(pos, eol, values[count])) {
+          count++;
+        }
 
-    auto last_idle = last->idle;
-    auto prev_idle = prev->idle;
+        if (count < 4) {
+          m_log.err("Failed to parse CPU values from %s", m_stat.path());
+          m_samples.idle.clear();
+          m_samples.total.clear();
+          return false;
+        }
 
-    auto diff = last->total - prev->total;
+        m_samples.idle.push_back(values[3]);
+        m_samples.total.push_back(values[0] + values[1] + values[2] + values[3] + values[7]);
+      }
 
-    if (diff == 0) {
-      return 0;
+      pos = eol + 1;
     }
 
-    float percentage = 100.0f * (diff - (last_idle - prev_idle)) / diff;
-
-    return math_util::cap<float>(percentage, 0, 100);
+    return !m_samples.total.empty();
   }
 }  // namespace modules
 
@@ -1,8 +1,8 @@
 #include "modules/fs.hpp"
 
-#include <sys/statvfs.h>
+#include <poll.h>
 
-#include <fstream>
+#include <cstring>
 #include <utility>
 
 #include "drawtypes/label.hpp"
@@ -22,6 +22,11 @@ POLYBAR_NS
 namespace modules {
   template class module<fs_module>;
 
+  /**
+   * How long an update waits for statvfs
+   */
+  static constexpr auto STATVFS_TIMEOUT = 2s;
+
   /**
    * Bootstrap the module by reading config values and
    * setting up required components
@@ -64,6 +69,10 @@ namespace modules {
       m_rampcapacity = load_ramp(m_conf, name(), TAG_RAMP_CAPACITY);
     }
 
+    for (auto&& mountpoint : m_mountpoints) {
+      m_mounts.emplace_back(std::make_unique<fs_mount>(mountpoint));
+    }
+
     // Warn about "unreachable" format tag
     if (m_formatter->has(TAG_LABEL_UNMOUNTED) && m_remove_unmounted) {
       m_log.warn("%s: Defined format tag \"%s\" will never be used (reason: `remove-unmounted = true`)", name(),
@@ -75,48 +84,29 @@ namespace modules {
    * Update mountpoints
    */
   bool fs_module::update() {
-    m_mounts.clear();
+    // Only happens if sleeping was cut short, e.g. right after starting
+    struct pollfd fds {
+      m_mountinfo.fd(), POLLPRI, 0
+    };
+    if (fds.fd != -1 && poll(&fds, 1, 0) > 0) {
+      m_mountinfo_changed = true;
+    }
 
-    vector<vector<string>> mountinfo;
-    std::ifstream filestream("/proc/self/mountinfo");
-    string line;
+    if (m_mountinfo_changed) {
+      m_mountinfo_changed = false;
+      read_mountinfo();
+    }
 
-    // Get details for mounted filesystems
-    while (std::getline(filestream, line)) {
-      auto cols = string_util::split(line, ' ');
-      if (std::find(m_mountpoints.begin(), m_mountpoints.end(), cols[MOUNTINFO_DIR]) != m_mountpoints.end()) {
-        mountinfo.emplace_back(move(cols));
+    // All calls run at the same time, a hung mount only delays the update once
+    auto deadline = chrono::steady_clock::now() + STATVFS_TIMEOUT;
+    for (auto&& mount : m_mounts) {
+      if (mount->mounted) {
+        start_query(*mount);
       }
     }
-
-    // Get data for defined mountpoints
-    for (auto&& mountpoint : m_mountpoints) {
-      auto details = std::find_if(mountinfo.begin(), mountinfo.end(),
-          [&](const vector<string>& m) { return m.size() > 4 && m[MOUNTINFO_DIR] == mountpoint; });
-
-      m_mounts.emplace_back(std::make_unique<fs_mount>(mountpoint, details != mountinfo.end()));
-      struct statvfs buffer {};
-
-      if (!m_mounts.back()->mounted) {
-        m_log.warn("%s: Mountpoint %s is not mounted", name(), mountpoint);
-      } else if (statvfs(mountpoint.c_str(), &buffer) == -1) {
-        m_log.err("%s: Failed to query filesystem (statvfs() error: %s)", name(), strerror(errno));
-      } else {
-        auto& mount = m_mounts.back();
-        mount->mountpoint = details->at(MOUNTINFO_DIR);
-        mount->type = details->at(MOUNTINFO_TYPE);
-        mount->fsname = details->at(MOUNTINFO_FSNAME);
-
-        // see: https://en.cppreference.com/w/cpp/filesystem/space
-        mount->bytes_total = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_blocks);
-        mount->bytes_free = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_bfree);
-        mount->bytes_used = mount->bytes_total - mount->bytes_free;
-        mount->bytes_avail = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_bavail);
-
-        mount->percentage_free =
-            math_util::percentage<double>(mount->bytes_avail, mount->bytes_used + mount->bytes_avail);
-        mount->percentage_used =
-            math_util::percentage<double>(mount->bytes_used, mount->bytes_used + mount->bytes_avail);
+    for (auto&& mount : m_mounts) {
+      if (mount->mounted) {
+        finish_query(*mount, deadline);
       }
     }
 
@@ -136,6 +126,157 @@ namespace modules {
     return true;
   }
 
+  /**
+   * Sleeps like any other timer module, but wakes up early when the mount
+   * table changes
+   */
+  void fs_module::sleep_until(chrono::steady_clock::time_point point) {
+    while (running()) {
+      auto now = chrono::steady_clock::now();
+      auto timeout = point > now ? chrono::duration_cast<chrono::milliseconds>(point - now).count() + 1 : 0;
+
+      struct pollfd fds[] = {
+          {m_wakeup.fd(), POLLIN, 0},
+          {m_mountinfo.fd(), POLLPRI, 0},
+      };
+
+      if (poll(fds, 2, static_cast<int>(timeout)) == -1 && errno != EINTR) {
+        throw module_error("Failed to poll " + m_mountinfo.path() + " (" + string(strerror(errno)) + ")");
+      }
+
+      // Notified by wakeup(), e.g. when the module is stopped
+      if (fds[0].revents & POLLIN) {
+        m_wakeup.drain();
+        return;
+      }
+
+      if (fds[1].revents & (POLLPRI | POLLERR)) {
+        m_mountinfo_changed = true;
+        return;
+      }
+
+      if (chrono::steady_clock::now() >= point) {
+        return;
+      }
+    }
+  }
+
+  void fs_module::wakeup() {
+    if (!m_wakeup.notify()) {
+      m_log.err("%s: Failed to wake up module (%s)", name(), strerror(errno));
+    }
+    module::wakeup();
+  }
+
+  /**
+   * Updates the mount state, type and fsname of all mountpoints
+   */
+  void fs_module::read_mountinfo() {
+    if (!m_mountinfo.read()) {
+      m_log.err("%s: Failed to read %s", name(), m_mountinfo.path());
+      return;
+    }
+
+    for (auto&& mount : m_mounts) {
+      mount->mounted = false;
+    }
+
+    const char* pos = m_mountinfo.data();
+    const char* end = pos + m_mountinfo.size();
+
+    while (pos < end) {
+      auto eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (eol == nullptr) {
+        eol = end;
+      }
+
+      // Get details for mounted filesystems
+      auto cols = string_util::split(string(pos, eol), ' ');
+      pos = eol + 1;
+
+      if (cols.size() <= MOUNTINFO_FSNAME) {
+        continue;
+      }
+
+      for (auto&& mount : m_mounts) {
+        if (!mount->mounted && mount->mountpoint == cols[MOUNTINFO_DIR]) {
+          mount->mounted = true;
+          mount->type = cols[MOUNTINFO_TYPE];
+          mount->fsname = cols[MOUNTINFO_FSNAME];
+        }
+      }
+    }
+
+    for (auto&& mount : m_mounts) {
+      if (!mount->mounted) {
+        m_log.warn("%s: Mountpoint %s is not mounted", name(), mount->mountpoint);
+      }
+    }
+  }
+
+  /**
+   * Starts a statvfs call for the mount unless the last one is still running
+   */
+  void fs_module::start_query(fs_mount& mount) {
+    if (mount.query) {
+      return;
+    }
+
+    auto query = make_shared<fs_query>();
+    mount.query = query;
+
+    thread([query, path = mount.mountpoint] {
+      struct statvfs buffer {};
+      int error = statvfs(path.c_str(), &buffer) == -1 ? errno : 0;
+
+      std::lock_guard<std::mutex> guard(query->lock);
+      query->result = buffer;
+      query->error = error;
+      query->done = true;
+      query->cv.notify_all();
+    }).detach();
+  }
+
+  /**
+   * Waits for the statvfs call of the mount until `deadline`
+   *
+   * If the call does not finish in time, the values of the last call are
+   * kept.
+   */
+  void fs_module::finish_query(fs_mount& mount, chrono::steady_clock::time_point deadline) {
+    auto query = mount.query;
+    std::unique_lock<std::mutex> guard(query->lock);
+
+    // Don't wait again for a mount that already timed out
+    if (!query->cv.wait_until(guard, mount.stale ? chrono::steady_clock::now() : deadline, [&] { return query->done; })) {
+      if (!mount.stale) {
+        m_log.warn("%s: Querying %s takes longer than %ds, showing the last values", name(), mount.mountpoint,
+            chrono::duration_cast<chrono::seconds>(STATVFS_TIMEOUT).count());
+        mount.stale = true;
+      }
+      return;
+    }
+
+    mount.query.reset();
+    mount.stale = false;
+
+    if (query->error != 0) {
+      m_log.err("%s: Failed to query filesystem (statvfs() error: %s)", name(), strerror(query->error));
+      return;
+    }
+
+    auto& buffer = query->result;
+
+    // see: https://en.cppreference.com/w/cpp/filesystem/space
+    mount.bytes_total = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_blocks);
+    mount.bytes_free = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_bfree);
+    mount.bytes_used = mount.bytes_total - mount.bytes_free;
+    mount.bytes_avail = static_cast<uint64_t>(buffer.f_frsize) * static_cast<uint64_t>(buffer.f_bavail);
+
+    mount.percentage_free = math_util::percentage<double>(mount.bytes_avail, mount.bytes_used + mount.bytes_avail);
+    mount.percentage_used = math_util::percentage<double>(mount.bytes_used, mount.bytes_used + mount.bytes_avail);
+  }
+
   /**
    * Generate the module output
    */
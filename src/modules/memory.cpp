@@ -1,6 +1,5 @@
-#include <fstream>
+#include <cstring>
 #include <iomanip>
-#include <istream>
 
 #include "drawtypes/label.hpp"
 #include "drawtypes/progressbar.hpp"
@@ -62,38 +61,51 @@ namespace modules {
     unsigned long long kb_avail{0ULL};
     unsigned long long kb_swap_total{0ULL};
     unsigned long long kb_swap_free{0ULL};
-
-    try {
-      std::ifstream meminfo(PATH_MEMORY_INFO);
-      std::map<std::string, unsigned long long int> parsed;
-
-      std::string line;
-      while (std::getline(meminfo, line)) {
-        size_t sep_off = line.find(':');
-        size_t value_off = line.find_first_of("123456789", sep_off);
-
-        if (sep_off == std::string::npos || value_off == std::string::npos) continue;
-
-        std::string id = line.substr(0, sep_off);
-        unsigned long long int value = std::strtoull(&line[value_off], nullptr, 10);
-        parsed[id] = value;
+    unsigned long long kb_free{0ULL};
+    unsigned long long kb_buffers{0ULL};
+    unsigned long long kb_cached{0ULL};
+    unsigned long long kb_reclaimable{0ULL};
+    unsigned long long kb_shmem{0ULL};
+    bool has_avail{false};
+
+    if (m_meminfo.read()) {
+      const pair<const char*, unsigned long long*> fields[]{{"MemTotal", &kb_total}, {"MemAvailable", &kb_avail},
+          {"MemFree", &kb_free}, {"Buffers", &kb_buffers}, {"Cached", &kb_cached}, {"SReclaimable", &kb_reclaimable},
+          {"Shmem", &kb_shmem}, {"SwapTotal", &kb_swap_total}, {"SwapFree", &kb_swap_free}};
+
+      const char* pos = m_meminfo.data();
+      const char* end = pos + m_meminfo.size();
+
+      while (pos < end) {
+        auto eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        if (eol == nullptr) {
+          eol = end;
+        }
+
+        auto sep = static_cast<const char*>(memchr(pos, ':', eol - pos));
+        if (sep != nullptr) {
+          for (const auto& field : fields) {
+            if (strncmp(pos, field.first, sep - pos) == 0 && field.first[sep - pos] == '\0') {
+              const char* value = sep + 1;
+              file_util::parse_number(value, eol, *field.second);
+              has_avail |= field.second == &kb_avail;
+              break;
+            }
+          }
+        }
+
+        pos = eol + 1;
       }
 
-      kb_total = parsed["MemTotal"];
-      kb_swap_total = parsed["SwapTotal"];
-      kb_swap_free = parsed["SwapFree"];
-
       // newer kernels (3.4+) have an accurate available memory field,
       // see https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/commit/?id=34e431b0ae398fc54ea69ff85ec700722c9da773
       // for details
-      if (parsed.count("MemAvailable")) {
-        kb_avail = parsed["MemAvailable"];
-      } else {
+      if (!has_avail) {
         // old kernel; give a best-effort approximation of available memory
-        kb_avail = parsed["MemFree"] + parsed["Buffers"] + parsed["Cached"] + parsed["SReclaimable"] - parsed["Shmem"];
+        kb_avail = kb_free + kb_buffers + kb_cached + kb_reclaimable - kb_shmem;
       }
-    } catch (const std::exception& err) {
-      m_log.err("Failed to read memory values (what: %s)", err.what());
+    } else {
+      m_log.err("Failed to read memory values from %s", m_meminfo.path());
     }
 
     m_perc_memfree = math_util::percentage(kb_avail, kb_total);
@@ -177,6 +177,20 @@ namespace modules {
   }
 
   // }}}
+
+  void replace_module(const module_t& old, const module_t& module, const vector<vector<module_t>*>& lists) {
+    for (auto* modules : lists) {
+      auto it = std::find(modules->begin(), modules->end(), old);
+      if (it != modules->end() && module) {
+        *it = module;
+      } else if (it != modules->end()) {
+        modules->erase(it);
+      }
+    }
+
+    old->stop();
+    old->join();
+  }
 } // namespace modules
 
 POLYBAR_NS_END
@@ -1,5 +1,7 @@
 #include "modules/meta/factory.hpp"
 
+#include <set>
+
 #include "modules/meta/all.hpp"
 
 POLYBAR_NS
@@ -119,6 +121,12 @@ namespace modules {
       throw application_error("Unknown module: " + type);
     }
   }
+
+  bool needs_main_thread(const string& type) {
+    static const std::set<string> x_modules{
+        TRAY_TYPE, XBACKLIGHT_TYPE, XKEYBOARD_TYPE, XWINDOW_TYPE, XWORKSPACES_TYPE};
+    return x_modules.find(type) != x_modules.end();
+  }
 } // namespace modules
 
 POLYBAR_NS_END
@@ -113,13 +113,13 @@ namespace modules {
   }
 
   void network_module::teardown() {
+    std::lock_guard<mutex> guard(m_polllock);
     m_wireless.reset();
     m_wired.reset();
   }
 
   bool network_module::update() {
-    net::network* network =
-        m_wireless ? static_cast<net::network*>(m_wireless.get()) : static_cast<net::network*>(m_wired.get());
+    net::network* network = this->network();
 
     if (!network->query(m_accumulate)) {
       m_log.warn("%s: Failed to query interface '%s'", name(), m_interface);
@@ -142,7 +142,8 @@ namespace modules {
     if (m_counter == -1) {
       m_counter = 0;
     } else if (m_ping_nth_update > 0 && m_connected && (++m_counter % m_ping_nth_update) == 0) {
-      m_packetloss = !network->ping();
+      // The result arrives while sleeping
+      network->connectivity().start();
       m_counter = 0;
     }
 
@@ -212,6 +213,60 @@ namespace modules {
     return true;
   }
 
+  /**
+   * Sleeps like any other timer module, but wakes up early to update the
+   * output when the link or its addresses change or when a connectivity
+   * check finishes
+   */
+  void network_module::sleep_until(chrono::steady_clock::time_point point) {
+    std::unique_lock<mutex> guard(m_polllock);
+    net::network* network = this->network();
+
+    while (running() && network != nullptr) {
+      auto& check = network->connectivity();
+      auto now = chrono::steady_clock::now();
+      auto until = std::min(point, check.deadline());
+      auto timeout = until > now ? chrono::duration_cast<chrono::milliseconds>(until - now).count() + 1 : 0;
+
+      m_pollfds.clear();
+      m_pollfds.push_back({m_wakeup.fd(), POLLIN, 0});
+      m_pollfds.push_back({check.fd(), POLLIN, 0});
+      network->events_fds(m_pollfds);
+
+      if (poll(m_pollfds.data(), m_pollfds.size(), static_cast<int>(timeout)) == -1 && errno != EINTR) {
+        throw module_error("Failed to poll network sockets (" + string(strerror(errno)) + ")");
+      }
+
+      // Notified by wakeup(), e.g. when the module is stopped
+      if (m_pollfds[0].revents & POLLIN) {
+        m_wakeup.drain();
+        return;
+      }
+
+      bool changed = network->process_events();
+
+      if (check.process()) {
+        m_packetloss = !check.reachable();
+        changed = true;
+      }
+
+      if (changed || chrono::steady_clock::now() >= point) {
+        return;
+      }
+    }
+  }
+
+  void network_module::wakeup() {
+    if (!m_wakeup.notify()) {
+      m_log.err("%s: Failed to wake up module (%s)", name(), strerror(errno));
+    }
+    module::wakeup();
+  }
+
+  net::network* network_module::network() const {
+    return m_wireless ? static_cast<net::network*>(m_wireless.get()) : static_cast<net::network*>(m_wired.get());
+  }
+
   void network_module::subthread_routine() {
     const chrono::milliseconds framerate{m_animation_packetloss->framerate()};
 
@@ -6,14 +6,35 @@
 POLYBAR_NS
 
 namespace modules {
+  /**
+   * Reads the mode from the `tail` and `coprocess` settings
+   */
+  static script_runner::mode get_mode(const config& conf, const string& name) {
+    bool tail = conf.get(name, "tail", false);
+    bool coprocess = conf.get(name, "coprocess", false);
+
+    if (tail && coprocess) {
+      throw module_error("tail and coprocess cannot be used together");
+    }
+
+    if (tail) {
+      return script_runner::mode::TAIL;
+    } else if (coprocess) {
+      return script_runner::mode::COPROCESS;
+    }
+    return script_runner::mode::INTERVAL;
+  }
+
   script_module::script_module(const bar_settings& bar, string name_, const config& config)
       : module<script_module>(bar, move(name_), config)
-      , m_tail(m_conf.get(name(), "tail", false))
-      , m_interval_success(m_conf.get<script_runner::interval>(name(), "interval", m_tail ? 0s : 5s))
+      , m_mode(get_mode(m_conf, name()))
+      , m_interval_success(m_conf.get<script_runner::interval>(
+            name(), "interval", m_mode == script_runner::mode::TAIL ? 0s : 5s))
       , m_interval_fail(m_conf.get<script_runner::interval>(name(), "interval-fail", m_interval_success))
       , m_interval_if(m_conf.get<script_runner::interval>(name(), "interval-if", m_interval_success))
       , m_runner([this](const auto& data) { handle_runner_update(data); }, m_conf.get(name(), "exec", ""s),
-            m_conf.get(name(), "exec-if", ""s), m_tail, m_interval_success, m_interval_fail,
+            m_conf.get(name(), "exec-if", ""s), m_mode, m_interval_success, m_interval_fail,
+            m_conf.get<script_runner::interval>(name(), "coprocess-timeout", 5s),
             m_conf.get_with_prefix(name(), "env-")) {
     // Load configured click handlers
     m_actions[mousebtn::LEFT] = m_conf.get(name(), "click-left", ""s);
@@ -118,7 +139,7 @@ namespace modules {
         auto action_replaced = string_util::replace_all(action, "%counter%", cnt);
 
         /*
-         * The pid token is only for tailed commands.
+         * The pid token is only for tailed commands and coprocesses.
          * If the command is not specified or running, replacement is unnecessary as well
          */
         if (data.pid != -1) {
@@ -50,6 +50,7 @@ namespace modules {
     if (!file_util::exists(m_path)) {
       throw module_error("The file '" + m_path + "' does not exist");
     }
+    m_file = make_unique<proc_file>(m_path);
 
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL, {TAG_LABEL, TAG_RAMP});
     m_formatter->add(FORMAT_WARN, TAG_LABEL_WARN, {TAG_LABEL_WARN, TAG_RAMP});
@@ -72,7 +73,7 @@ namespace modules {
   }
 
   bool temperature_module::update() {
-    float temp = float(std::strtol(file_util::contents(m_path).c_str(), nullptr, 10)) / 1000.0;
+    float temp = float(m_file->read_number()) / 1000.0;
     m_temp     = std::lround( temp );
     int temp_f = std::lround( (temp * 1.8) + 32.0 );
     int temp_k = std::lround( temp + 273.15 );
@@ -22,7 +22,7 @@ using namespace polybar;
 using namespace eventloop;
 
 static const char* exec = nullptr;
-static constexpr auto USAGE = "<command=(action|cmd)> <payload> [...]";
+static constexpr auto USAGE = "<command=(action|cmd|stats)> <payload> [...]";
 static constexpr auto USAGE_HOOK = "hook <module-name> <hook-index>";
 
 void display(const string& msg) {
@@ -50,7 +50,7 @@ void remove_socket(const string& handle) {
 }
 
 bool validate_type(const string& type) {
-  return (type == "action" || type == "cmd" || type == "hook");
+  return (type == "action" || type == "cmd" || type == "hook" || type == "stats");
 }
 
 static vector<string> get_sockets() {
@@ -108,8 +108,11 @@ static std::pair<ipc::type_t, string> parse_message(deque<string> args) {
   // Validate args
   const string ipc_type{args.front()};
   args.pop_front();
-  string ipc_payload{args.front()};
-  args.pop_front();
+  string ipc_payload;
+  if (!args.empty()) {
+    ipc_payload = args.front();
+    args.pop_front();
+  }
 
   if (!validate_type(ipc_type)) {
     error("\"" + ipc_type + "\" is not a valid message type.");
@@ -169,6 +172,13 @@ static std::pair<ipc::type_t, string> parse_message(deque<string> args) {
     type = to_integral(ipc::v0::ipc_type::CMD);
   }
 
+  /*
+   * polybar-msg stats [text|json]
+   */
+  if (ipc_type == "stats") {
+    type = to_integral(ipc::v0::ipc_type::STATS);
+  }
+
   if (!args.empty()) {
     error("Too many arguments");
   }
@@ -212,7 +222,8 @@ int run(int argc, char** argv) {
     error("No active ipc channels");
   }
 
-  if (args.size() < 2) {
+  // Only stats requests may omit the payload
+  if (args.empty() || (args.size() < 2 && args.front() != "stats")) {
     usage(stderr, USAGE);
     return EXIT_FAILURE;
   }
@@ -220,7 +231,8 @@ int run(int argc, char** argv) {
   string payload;
   ipc::type_t type;
   std::tie(type, payload) = parse_message(args);
-  string type_str = type == to_integral(ipc::v0::ipc_type::ACTION) ? "action" : "command";
+  bool is_stats = type == to_integral(ipc::v0::ipc_type::STATS);
+  string type_str = is_stats ? "stats request" : type == to_integral(ipc::v0::ipc_type::ACTION) ? "action" : "command";
 
   bool success = true;
 
@@ -238,10 +250,15 @@ int run(int argc, char** argv) {
     assert(pid > 0);
 
     decoders.emplace_back(
-        null_logger, [pid, channel, &payload, &type_str, &success](uint8_t, ipc::type_t type, const auto& response) {
+        null_logger,
+        [pid, channel, is_stats, &payload, &type_str, &success](uint8_t, ipc::type_t type, const auto& response) {
           switch (type) {
             case ipc::TYPE_OK:
-              printf("Successfully wrote %s '%s' to PID %d\n", type_str.c_str(), payload.c_str(), pid);
+              if (is_stats) {
+                printf("%s\n", string{response.begin(), response.end()}.c_str());
+              } else {
+                printf("Successfully wrote %s '%s' to PID %d\n", type_str.c_str(), payload.c_str(), pid);
+              }
               break;
             case ipc::TYPE_ERR: {
               string err_str{response.begin(), response.end()};
@@ -1,6 +1,8 @@
 #include "tags/action_context.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <set>
 
 POLYBAR_NS
 
@@ -8,9 +10,11 @@ namespace tags {
 
   void action_context::reset() {
     m_action_blocks.clear();
+    invalidate_index();
   }
 
   action_t action_context::action_open(mousebtn btn, const string&& cmd, alignment align, double x) {
+    invalidate_index();
     action_t id = m_action_blocks.size();
     m_action_blocks.emplace_back(std::move(cmd), btn, align, true);
     set_start(id, x);
@@ -33,10 +37,12 @@ namespace tags {
   }
 
   void action_context::set_start(action_t id, double x) {
+    invalidate_index();
     m_action_blocks[id].start_x = x;
   }
 
   void action_context::set_end(action_t id, double x) {
+    invalidate_index();
     /*
      * Only ever increase the end position.
      * A larger end position may have been set before.
@@ -46,6 +52,7 @@ namespace tags {
 
   void action_context::compensate_for_negative_move(alignment a, double old_x, double new_x) {
     assert(new_x < old_x);
+    invalidate_index();
     for (auto& block : m_action_blocks) {
       if (block.is_open && block.align == a) {
         // Move back the start position if a smaller position is observed
@@ -62,6 +69,7 @@ namespace tags {
   }
 
   void action_context::set_alignment_start(const alignment a, const double x) {
+    invalidate_index();
     m_align_start[a] = x;
   }
 
@@ -69,24 +77,31 @@ namespace tags {
     std::map<mousebtn, tags::action_t> buttons;
 
     for (int i = static_cast<int>(mousebtn::NONE); i < static_cast<int>(mousebtn::BTN_COUNT); i++) {
-      buttons[static_cast<mousebtn>(i)] = tags::NO_ACTION;
-    }
-
-    for (action_t id = 0; (unsigned)id < m_action_blocks.size(); id++) {
-      auto action = m_action_blocks[id];
-      mousebtn btn = action.button;
-
-      // Higher IDs are higher in the action stack.
-      if (id > buttons[btn] && action.test(m_align_start.at(action.align), x)) {
-        buttons[action.button] = id;
-      }
+      auto btn = static_cast<mousebtn>(i);
+      buttons[btn] = has_action(btn, x);
     }
 
     return buttons;
   }
 
+  /**
+   * Finds the topmost action for the given button at position x.
+   *
+   * This is a binary search in the interval index of that button.
+   */
   action_t action_context::has_action(mousebtn btn, int x) const {
-    return get_actions(x)[btn];
+    if (m_index_dirty) {
+      build_index();
+    }
+
+    const auto& index = m_index[static_cast<size_t>(btn)];
+    auto it = std::upper_bound(index.bounds.begin(), index.bounds.end(), x);
+
+    if (it == index.bounds.begin()) {
+      return NO_ACTION;
+    }
+
+    return index.top[std::distance(index.bounds.begin(), it) - 1];
   }
 
   string action_context::get_action(action_t id) const {
@@ -125,6 +140,68 @@ namespace tags {
   const std::vector<action_block>& action_context::get_blocks() const {
     return m_action_blocks;
   }
+
+  void action_context::invalidate_index() {
+    m_index_dirty = true;
+  }
+
+  /**
+   * Builds the interval index for all buttons.
+   *
+   * For every button, the block boundaries are swept from left to right while
+   * keeping track of the blocks covering the current position. The block with
+   * the highest id is the one on top.
+   */
+  void action_context::build_index() const {
+    // (position, id) pairs, negative ids (-id - 1) mark the end of a block.
+    std::array<vector<std::pair<int, action_t>>, static_cast<size_t>(mousebtn::BTN_COUNT)> events;
+
+    for (action_t id = 0; (unsigned)id < m_action_blocks.size(); id++) {
+      const auto& block = m_action_blocks[id];
+      double align_start = m_align_start.at(block.align);
+      int start = static_cast<int>(block.start_x + align_start);
+      int end = static_cast<int>(block.end_x + align_start);
+
+      if (start >= end) {
+        continue;
+      }
+
+      auto& btn_events = events[static_cast<size_t>(block.button)];
+      btn_events.emplace_back(start, id);
+      btn_events.emplace_back(end, -id - 1);
+    }
+
+    for (size_t btn = 0; btn < events.size(); btn++) {
+      auto& btn_events = events[btn];
+      auto& index = m_index[btn];
+      index.bounds.clear();
+      index.top.clear();
+
+      std::sort(btn_events.begin(), btn_events.end(),
+          [](const auto& a, const auto& b) { return a.first < b.first; });
+
+      std::set<action_t> active;
+
+      for (size_t i = 0; i < btn_events.size();) {
+        int pos = btn_events[i].first;
+
+        for (; i < btn_events.size() && btn_events[i].first == pos; i++) {
+          action_t id = btn_events[i].second;
+          if (id >= 0) {
+            active.insert(id);
+          } else {
+            active.erase(-id - 1);
+          }
+        }
+
+        // Higher IDs are higher in the action stack.
+        index.bounds.push_back(pos);
+        index.top.push_back(active.empty() ? NO_ACTION : *active.rbegin());
+      }
+    }
+
+    m_index_dirty = false;
+  }
 } // namespace tags
 
 POLYBAR_NS_END
@@ -1,5 +1,6 @@
 #include "utils/command.hpp"
 
+#include <fcntl.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -13,13 +14,6 @@
 #include "utils/process.hpp"
 #include "utils/string.hpp"
 
-#ifndef STDOUT_FILENO
-#define STDOUT_FILENO 1
-#endif
-#ifndef STDERR_FILENO
-#define STDERR_FILENO 2
-#endif
-
 POLYBAR_NS
 
 command<output_policy::IGNORED>::command(const logger& logger, string cmd) : m_log(logger), m_cmd(move(cmd)) {}
@@ -32,7 +26,9 @@ command<output_policy::IGNORED>::~command() {
  * Execute the command
  */
 int command<output_policy::IGNORED>::exec(bool wait_for_completion) {
-  m_forkpid = process_util::spawn_async([m_cmd = m_cmd] { process_util::exec_sh(m_cmd.c_str()); });
+  process_util::spawn_options options;
+  options.new_session = true;
+  m_forkpid = process_util::spawn_sh(m_cmd, {}, options);
   if (wait_for_completion) {
     auto status = wait();
     m_forkpid = -1;
@@ -99,12 +95,13 @@ int command<output_policy::IGNORED>::get_exit_status() {
   return WEXITSTATUS(m_forkstatus);
 }
 
-command<output_policy::REDIRECTED>::command(const polybar::logger& logger, std::string cmd)
-    : command<output_policy::IGNORED>(logger, move(cmd)) {
-  if (pipe(m_stdin) != 0) {
+command<output_policy::REDIRECTED>::command(const polybar::logger& logger, std::string cmd, bool redirect_stderr)
+    : command<output_policy::IGNORED>(logger, move(cmd)), m_redirect_stderr(redirect_stderr) {
+  // Only the ends connected to the child's stdio are inherited by it
+  if (pipe2(m_stdin, O_CLOEXEC) != 0) {
     throw command_error("Failed to allocate input stream");
   }
-  if (pipe(m_stdout) != 0) {
+  if (pipe2(m_stdout, O_CLOEXEC) != 0) {
     throw command_error("Failed to allocate output stream");
   }
 }
@@ -128,51 +125,21 @@ command<output_policy::REDIRECTED>::~command() {
  * Execute the command
  */
 int command<output_policy::REDIRECTED>::exec(bool wait_for_completion, const vector<pair<string, string>>& env) {
-  if ((m_forkpid = fork()) == -1) {
-    throw system_error("Failed to fork process");
-  }
-
-  if (process_util::in_forked_process(m_forkpid)) {
-    if (dup2(m_stdin[PIPE_READ], STDIN_FILENO) == -1) {
-      throw command_error("Failed to redirect stdin in child process");
-    }
-    if (dup2(m_stdout[PIPE_WRITE], STDOUT_FILENO) == -1) {
-      throw command_error("Failed to redirect stdout in child process");
-    }
-    if (dup2(m_stdout[PIPE_WRITE], STDERR_FILENO) == -1) {
-      throw command_error("Failed to redirect stderr in child process");
-    }
-
-    // Close file descriptors that won't be used by the child
-    if ((m_stdin[PIPE_READ] = close(m_stdin[PIPE_READ])) == -1) {
-      throw command_error("Failed to close fd");
-    }
-    if ((m_stdin[PIPE_WRITE] = close(m_stdin[PIPE_WRITE])) == -1) {
-      throw command_error("Failed to close fd");
-    }
-    if ((m_stdout[PIPE_READ] = close(m_stdout[PIPE_READ])) == -1) {
-      throw command_error("Failed to close fd");
-    }
-    if ((m_stdout[PIPE_WRITE] = close(m_stdout[PIPE_WRITE])) == -1) {
-      throw command_error("Failed to close fd");
-    }
+  int err = m_redirect_stderr ? m_stdout[PIPE_WRITE] : -1;
+  m_forkpid = process_util::spawn_sh(m_cmd, env, {m_stdin[PIPE_READ], m_stdout[PIPE_WRITE], err});
 
-    setpgid(m_forkpid, 0);
-    process_util::exec_sh(m_cmd.c_str(), env);
-  } else {
-    // Close file descriptors that won't be used by the parent
-    if ((m_stdin[PIPE_READ] = close(m_stdin[PIPE_READ])) == -1) {
-      throw command_error("Failed to close fd");
-    }
-    if ((m_stdout[PIPE_WRITE] = close(m_stdout[PIPE_WRITE])) == -1) {
-      throw command_error("Failed to close fd");
-    }
+  // Close file descriptors that won't be used by the parent
+  if ((m_stdin[PIPE_READ] = close(m_stdin[PIPE_READ])) == -1) {
+    throw command_error("Failed to close fd");
+  }
+  if ((m_stdout[PIPE_WRITE] = close(m_stdout[PIPE_WRITE])) == -1) {
+    throw command_error("Failed to close fd");
+  }
 
-    if (wait_for_completion) {
-      auto status = wait();
-      m_forkpid = -1;
-      return status;
-    }
+  if (wait_for_completion) {
+    auto status = wait();
+    m_forkpid = -1;
+    return status;
   }
 
   return EXIT_SUCCESS;
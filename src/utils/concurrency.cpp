@@ -1,5 +1,8 @@
 #include "utils/concurrency.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <map>
 
 POLYBAR_NS
@@ -14,6 +17,45 @@ namespace concurrency_util {
     }
     return ids[id];
   }
+
+  void parallel_for(size_t count, const std::function<void(size_t)>& fn, size_t workers) {
+    if (workers == 0) {
+      workers = std::max(1U, thread::hardware_concurrency());
+    }
+    workers = std::min(workers, count);
+
+    std::atomic_size_t next{0};
+    std::exception_ptr error;
+    mutex error_mutex;
+
+    auto work = [&] {
+      for (size_t i; (i = next++) < count;) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<mutex> guard(error_mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    };
+
+    vector<thread> threads;
+    for (size_t i = 1; i < workers; i++) {
+      threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto&& t : threads) {
+      t.join();
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }  // namespace concurrency_util
 
 POLYBAR_NS_END
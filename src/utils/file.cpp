@@ -3,6 +3,7 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <glob.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -137,6 +138,131 @@ int fd_streambuf::underflow() {
   return traits_type::to_int_type(*gptr());
 }
 
+// }}}
+// implementation of mapped_file {{{
+
+mapped_file::mapped_file(const string& path) {
+  file_descriptor fd(path, O_RDONLY);
+  struct stat info {};
+
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    m_size = info.st_size;
+    m_map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m_map == MAP_FAILED) {
+      m_map = nullptr;
+    }
+  }
+
+  if (m_map == nullptr) {
+    char buf[BUFSIZ];
+    ssize_t bytes;
+    while ((bytes = read(fd, buf, sizeof(buf))) > 0) {
+      m_buffer.append(buf, bytes);
+    }
+    if (bytes == -1) {
+      throw system_error("Failed to read " + path);
+    }
+    m_size = m_buffer.size();
+  }
+}
+
+mapped_file::~mapped_file() {
+  if (m_map != nullptr) {
+    munmap(m_map, m_size);
+  }
+}
+
+const char* mapped_file::data() const {
+  return m_map != nullptr ? static_cast<const char*>(m_map) : m_buffer.data();
+}
+
+size_t mapped_file::size() const {
+  return m_size;
+}
+
+// }}}
+
+// implementation of proc_file {{{
+
+proc_file::proc_file(string path) : m_path(move(path)), m_buffer(BUFSIZ) {
+  m_buffer[0] = '\0';
+}
+
+proc_file::~proc_file() {
+  if (m_fd != -1) {
+    close(m_fd);
+  }
+}
+
+bool proc_file::read() {
+  m_size = 0;
+  m_buffer[0] = '\0';
+
+  if (m_fd == -1 && (m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+    return false;
+  }
+
+  ssize_t bytes;
+  while ((bytes = pread(m_fd, m_buffer.data() + m_size, m_buffer.size() - m_size - 1, m_size)) > 0) {
+    m_size += bytes;
+
+    // Keep room for the terminating null byte
+    if (m_size + 1 == m_buffer.size()) {
+      m_buffer.resize(m_buffer.size() * 2);
+    }
+  }
+
+  if (bytes == -1) {
+    close(m_fd);
+    m_fd = -1;
+    m_size = 0;
+  }
+
+  m_buffer[m_size] = '\0';
+  return bytes != -1;
+}
+
+const char* proc_file::data() const {
+  return m_buffer.data();
+}
+
+size_t proc_file::size() const {
+  return m_size;
+}
+
+long long proc_file::read_number(long long fallback) {
+  if (!read()) {
+    return fallback;
+  }
+
+  const char* pos = data();
+  const char* end = pos + size();
+  bool negative = false;
+
+  while (pos < end && (*pos == ' ' || *pos == '\t')) {
+    pos++;
+  }
+  if (pos < end && *pos == '-') {
+    negative = true;
+    pos++;
+  }
+
+  unsigned long long value;
+  if (!file_util::parse_number(pos, end, value)) {
+    return fallback;
+  }
+
+  return negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+}
+
+const string& proc_file::path() const {
+  return m_path;
+}
+
+int proc_file::fd() const {
+  return m_fd;
+}
+
 // }}}
 
 namespace file_util {
@@ -194,17 +320,20 @@ namespace file_util {
    * Gets the contents of the given file
    */
   string contents(const string& filename) {
-    try {
-      string contents;
-      string line;
-      std::ifstream in(filename, std::ifstream::in);
-      while (std::getline(in, line)) {
-        contents += line + '\n';
-      }
-      return contents;
-    } catch (const std::ifstream::failure& e) {
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
       return "";
     }
+
+    string contents;
+    char buf[BUFSIZ];
+    ssize_t bytes;
+    while ((bytes = read(fd, buf, sizeof(buf))) > 0) {
+      contents.append(buf, bytes);
+    }
+    close(fd);
+
+    return bytes == -1 ? "" : contents;
   }
 
   /**
@@ -280,7 +409,8 @@ namespace file_util {
     is_absolute = !ret.empty() && (ret.at(0) == '/');
 
     if (!is_absolute && !relative_to.empty()) {
-      return relative_to + "/" + ret;
+      // dirname() keeps the trailing slash
+      return relative_to + (relative_to.back() == '/' ? "" : "/") + ret;
     }
     return ret;
   }
@@ -354,6 +484,23 @@ namespace file_util {
     throw system_error("Failed to open directory stream for " + dirname);
   }
 
+  bool parse_number(const char*& pos, const char* end, unsigned long long& value) {
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+      pos++;
+    }
+
+    if (pos == end || *pos < '0' || *pos > '9') {
+      return false;
+    }
+
+    value = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+      value = value * 10 + (*pos - '0');
+    }
+
+    return true;
+  }
+
   string dirname(const string& path) {
     const auto pos = path.find_last_of('/');
     if (pos != string::npos) {
@@ -0,0 +1,125 @@
+#include "utils/launcher.hpp"
+
+#include <dirent.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "components/logger.hpp"
+#include "errors.hpp"
+#include "utils/process.hpp"
+
+POLYBAR_NS
+
+/**
+ * Closes all file descriptors except stdin, stdout, stderr and `keep`
+ *
+ * The helper is forked after polybar connected to X, neither it nor the
+ * commands it starts should hold on to that connection or any other file
+ * polybar opened.
+ */
+static void close_inherited_fds(int keep) {
+  vector<int> fds;
+
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir != nullptr) {
+    while (auto* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        fds.push_back(atoi(entry->d_name));
+      }
+    }
+    closedir(dir);
+  } else {
+    for (long fd = STDERR_FILENO + 1, max = sysconf(_SC_OPEN_MAX); fd < max; fd++) {
+      fds.push_back(fd);
+    }
+  }
+
+  for (int fd : fds) {
+    if (fd > STDERR_FILENO && fd != keep) {
+      close(fd);
+    }
+  }
+}
+
+launcher::launcher() {
+  int fds[2];
+
+  // Message boundaries are kept, each message is a single command
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+    throw system_error("Failed to create launcher socket");
+  }
+
+  if ((m_pid = fork()) == -1) {
+    close(fds[0]);
+    close(fds[1]);
+    throw system_error("Failed to fork launcher");
+  }
+
+  if (m_pid == 0) {
+    close_inherited_fds(fds[1]);
+    serve(fds[1]);
+  }
+
+  close(fds[1]);
+  m_fd = fds[0];
+}
+
+launcher::~launcher() {
+  close(m_fd);
+
+  // The helper exits once it sees the socket closed. Reap it even if a signal
+  // interrupts the wait, an instance started by exec() would never do that.
+  while (waitpid(m_pid, nullptr, 0) == -1 && errno == EINTR) {
+  }
+}
+
+bool launcher::run(const string& cmd) {
+  // An empty message could not be told apart from the socket being closed
+  if (cmd.empty()) {
+    return true;
+  }
+
+  return send(m_fd, cmd.data(), cmd.size(), MSG_DONTWAIT | MSG_NOSIGNAL) == static_cast<ssize_t>(cmd.size());
+}
+
+/**
+ * Main loop of the helper process
+ */
+void launcher::serve(int fd) {
+  // Children are reaped by the kernel
+  struct sigaction act {};
+  act.sa_handler = SIG_IGN;
+  act.sa_flags = SA_NOCLDWAIT;
+  sigaction(SIGCHLD, &act, nullptr);
+
+  string cmd;
+  process_util::spawn_options options;
+  options.new_session = true;
+
+  while (true) {
+    ssize_t size = recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC);
+
+    if (size == -1 && errno == EINTR) {
+      continue;
+    } else if (size <= 0) {
+      break;
+    }
+
+    cmd.resize(size);
+    if (recv(fd, &cmd[0], cmd.size(), 0) != size) {
+      break;
+    }
+
+    try {
+      process_util::spawn_sh(cmd, {}, options);
+    } catch (const system_error& err) {
+      logger::make().err("launcher: %s (cmd: %s)", err.what(), cmd);
+    }
+  }
+
+  _exit(EXIT_SUCCESS);
+}
+
+POLYBAR_NS_END
@@ -0,0 +1,134 @@
+#include "utils/perf.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+POLYBAR_NS
+
+namespace perf_util {
+  void histogram::record(clock::duration duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+    m_buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  uint64_t histogram::count() const {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  uint64_t histogram::total() const {
+    return m_total.load(std::memory_order_relaxed);
+  }
+
+  uint64_t histogram::max() const {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  uint64_t histogram::percentile(double p) const {
+    uint64_t total = 0;
+    for (const auto& b : m_buckets) {
+      total += b.load(std::memory_order_relaxed);
+    }
+
+    if (total == 0) {
+      return 0;
+    }
+
+    // Rank of the requested value, 1-based
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen >= rank) {
+        // The last bucket also collects all values that are out of range
+        return i == BUCKETS - 1 ? max() : std::min(upper_bound(i), max());
+      }
+    }
+
+    return max();
+  }
+
+  /**
+   * Values below SUB_BUCKETS get a bucket each. Larger values are split by
+   * their most significant bit and the two bits below it.
+   */
+  size_t histogram::bucket(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+
+    size_t msb = 63 - __builtin_clzll(value);
+    if (msb >= MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+
+    size_t sub = (value >> (msb - 2)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + (msb - 2) * SUB_BUCKETS + sub;
+  }
+
+  uint64_t histogram::upper_bound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+
+    size_t msb = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 2;
+    uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (msb - 2)) - 1;
+  }
+
+  string text_header(const string& label) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%-24s %10s %12s %9s %9s %9s %9s", label.c_str(), "count", "total(ms)", "p50(us)",
+        "p90(us)", "p99(us)", "max(us)");
+    return buf;
+  }
+
+  /**
+   * Formats one table row: label, count, total in ms and percentiles in us
+   */
+  string to_text(const string& label, const histogram& hist) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%-24s %10llu %12.3f %9llu %9llu %9llu %9llu", label.c_str(),
+        static_cast<unsigned long long>(hist.count()), hist.total() / 1000.0,
+        static_cast<unsigned long long>(hist.percentile(50)), static_cast<unsigned long long>(hist.percentile(90)),
+        static_cast<unsigned long long>(hist.percentile(99)), static_cast<unsigned long long>(hist.max()));
+    return buf;
+  }
+
+  string to_json(const histogram& hist) {
+    return "{\"count\":" + to_string(hist.count()) + ",\"total_us\":" + to_string(hist.total()) +
+           ",\"p50_us\":" + to_string(hist.percentile(50)) + ",\"p90_us\":" + to_string(hist.percentile(90)) +
+           ",\"p99_us\":" + to_string(hist.percentile(99)) + ",\"max_us\":" + to_string(hist.max()) + "}";
+  }
+
+  string json_escape(const string& value) {
+    string result;
+    result.reserve(value.size());
+
+    for (char c : value) {
+      if (c == '"' || c == '\\') {
+        result += '\\';
+        result += c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        result += buf;
+      } else {
+        result += c;
+      }
+    }
+
+    return result;
+  }
+} // namespace perf_util
+
+POLYBAR_NS_END
@@ -1,114 +1,151 @@
 #include "utils/process.hpp"
 
 #include <fcntl.h>
-#include <sys/stat.h>
+#include <signal.h>
+#include <spawn.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <mutex>
+
 #include "errors.hpp"
 #include "utils/env.hpp"
-#include "utils/string.hpp"
 
 POLYBAR_NS
 
 namespace process_util {
   /**
-   * Check if currently in main process
-   */
-  bool in_parent_process(pid_t pid) {
-    return pid != -1 && pid != 0;
-  }
-
-  /**
-   * Check if currently in subprocess
+   * Children started with spawn_detached that were not reaped yet
    */
-  bool in_forked_process(pid_t pid) {
-    return pid == 0;
-  }
+  static vector<pid_t> g_detached;
+  static std::mutex g_detached_lock;
 
   /**
-   * Redirects all io fds (stdin, stdout, stderr) of the current process to /dev/null.
+   * @returns The current environment with the given variables added or replaced
    */
-  void redirect_stdio_to_dev_null() {
-    auto redirect = [](int fd_to_redirect) {
-      int fd = open("/dev/null", O_WRONLY);
-      if (fd < 0 || dup2(fd, fd_to_redirect) < 0) {
-        throw system_error("Failed to redirect process output");
+  static vector<string> make_environment(const vector<pair<string, string>>& env) {
+    vector<string> result;
+
+    for (char** var = environ; *var != nullptr; var++) {
+      string entry{*var};
+      string name{entry.substr(0, entry.find('='))};
+      if (std::none_of(env.begin(), env.end(), [&](const auto& kv) { return kv.first == name; })) {
+        result.emplace_back(move(entry));
       }
-      close(fd);
-    };
+    }
 
-    redirect(STDIN_FILENO);
-    redirect(STDOUT_FILENO);
-    redirect(STDERR_FILENO);
+    for (const auto& kv : env) {
+      result.emplace_back(kv.first + "=" + kv.second);
+    }
+
+    return result;
   }
 
   /**
-   * Forks a child process and executes the given lambda function in it.
+   * Runs the given command using the shell in a new process.
+   *
+   * The process is created with posix_spawn, which does not copy the address
+   * space of polybar (glibc and musl use vfork semantics), so the cost does not
+   * grow with the size of the bar. The child starts with an empty signal mask
+   * and the default signal dispositions and is the leader of a new process
+   * group, so that it can be terminated with killpg.
    *
    * Processes spawned this way need to be waited on by the caller.
+   *
+   * @throws system_error if the process could not be created
    */
-  pid_t spawn_async(std::function<void()> const& lambda) {
-    pid_t pid = fork();
-    switch (pid) {
-      case -1:
-        throw runtime_error("fork_detached: Unable to fork: " + string(strerror(errno)));
-      case 0:
-        // Child
-        setsid();
-        umask(0);
-        redirect_stdio_to_dev_null();
-        lambda();
-        _Exit(0);
-        break;
-      default:
-        return pid;
+  pid_t spawn_sh(const string& cmd, const vector<pair<string, string>>& env, const spawn_options& options) {
+    static const string shell{env_util::get("POLYBAR_SHELL", "/bin/sh")};
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    const int fds[]{options.in, options.out, options.err};
+    for (int target : {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO}) {
+      if (fds[target] == -1) {
+        posix_spawn_file_actions_addopen(
+            &actions, target, "/dev/null", target == STDIN_FILENO ? O_RDONLY : O_WRONLY, 0);
+      } else {
+        posix_spawn_file_actions_adddup2(&actions, fds[target], target);
+      }
     }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigfillset(&defaults);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP;
+    posix_spawnattr_setpgroup(&attr, 0);
+#ifdef POSIX_SPAWN_SETSID
+    // A session leader cannot change its process group
+    if (options.new_session) {
+      flags = (flags & ~POSIX_SPAWN_SETPGROUP) | POSIX_SPAWN_SETSID;
+    }
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    vector<string> environment;
+    vector<char*> envp;
+    if (!env.empty()) {
+      environment = make_environment(env);
+      for (auto& var : environment) {
+        envp.push_back(&var[0]);
+      }
+      envp.push_back(nullptr);
+    }
+
+    const char* argv[]{shell.c_str(), "-c", cmd.c_str(), nullptr};
+    pid_t pid;
+    int err = posix_spawnp(&pid, shell.c_str(), &actions, &attr, const_cast<char* const*>(argv),
+        env.empty() ? environ : envp.data());
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0) {
+      errno = err;
+      throw system_error("Failed to spawn '" + shell + "'");
+    }
+
+    return pid;
   }
 
   /**
-   * Forks a child process and completely detaches it.
-   *
-   * In the child process, the given lambda function is executed.
-   * We fork twice so that the first forked process can exit and it's child is
-   * reparented to the init process.
+   * Runs the given command using the shell in a new session and forgets about
+   * it.
    *
-   * Ref: https://web.archive.org/web/20120914180018/http://www.steve.org.uk/Reference/Unix/faq_2.html#SEC16
+   * The child is not waited on by the caller, reap_detached collects it once
+   * it has exited.
    *
-   * Use this if you want to run a command and just forget about it.
+   * @throws system_error if the process could not be created
+   */
+  void spawn_detached(const string& cmd) {
+    spawn_options options;
+    options.new_session = true;
+    pid_t pid = spawn_sh(cmd, {}, options);
+
+    std::lock_guard<std::mutex> guard(g_detached_lock);
+    g_detached.push_back(pid);
+  }
+
+  /**
+   * Reaps children started with spawn_detached that have exited.
    *
-   * @returns The PID of the child process
+   * @returns The number of detached children that are still running
    */
-  void fork_detached(std::function<void()> const& lambda) {
-    pid_t pid = fork();
-    switch (pid) {
-      case -1:
-        throw runtime_error("fork_detached: Unable to fork: " + string(strerror(errno)));
-      case 0:
-        // Child
-        setsid();
-
-        pid = fork();
-        switch (pid) {
-          case -1:
-            throw runtime_error("fork_detached: Unable to fork: " + string(strerror(errno)));
-          case 0:
-            // Child
-            umask(0);
-            redirect_stdio_to_dev_null();
-            lambda();
-            _Exit(0);
-        }
-
-        _Exit(0);
-      default:
-        /*
-         * The first fork immediately exits and we have to collect its exit
-         * status
-         */
-        wait(pid);
-    }
+  size_t reap_detached() {
+    std::lock_guard<std::mutex> guard(g_detached_lock);
+    g_detached.erase(std::remove_if(g_detached.begin(), g_detached.end(),
+                         [](pid_t pid) { return wait_for_completion_nohang(pid, nullptr) != 0; }),
+        g_detached.end());
+    return g_detached.size();
   }
 
   /**
@@ -121,22 +158,6 @@ namespace process_util {
     }
   }
 
-  /**
-   * Execute command using shell
-   */
-  void exec_sh(const char* cmd, const vector<pair<string, string>>& env) {
-    if (cmd != nullptr) {
-      static const string shell{env_util::get("POLYBAR_SHELL", "/bin/sh")};
-
-      for (const auto& kv_pair : env) {
-        setenv(kv_pair.first.data(), kv_pair.second.data(), 1);
-      }
-
-      execlp(shell.c_str(), shell.c_str(), "-c", cmd, nullptr);
-      throw system_error("execlp() failed");
-    }
-  }
-
   int wait(pid_t pid) {
     int forkstatus;
     do {
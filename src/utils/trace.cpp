@@ -0,0 +1,142 @@
+#include "utils/trace.hpp"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "utils/file.hpp"
+#include "utils/perf.hpp"
+
+POLYBAR_NS
+
+namespace trace_util {
+  namespace {
+    struct event {
+      string name;
+      char phase;
+      int64_t ts;
+      int64_t dur;
+      long tid;
+    };
+
+    std::atomic_bool g_enabled{false};
+    std::mutex g_lock;
+    vector<event> g_events;
+    size_t g_capacity{0};
+    size_t g_next{0};
+    string g_path;
+
+    int64_t now() {
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    }
+
+    long thread_id() {
+      static thread_local long tid = syscall(SYS_gettid);
+      return tid;
+    }
+
+    string event_name(const char* name, const string& detail) {
+      return detail.empty() ? string{name} : detail + " " + name;
+    }
+
+    void record(event&& e) {
+      std::lock_guard<std::mutex> guard(g_lock);
+
+      if (g_capacity == 0) {
+        return;
+      }
+
+      if (g_events.size() < g_capacity) {
+        g_events.emplace_back(std::move(e));
+      } else {
+        g_events[g_next] = std::move(e);
+      }
+
+      g_next = (g_next + 1) % g_capacity;
+    }
+  } // namespace
+
+  void start(const string& path, size_t capacity) {
+    std::lock_guard<std::mutex> guard(g_lock);
+    g_events.clear();
+    g_events.reserve(capacity);
+    g_capacity = capacity;
+    g_next = 0;
+    g_path = path;
+    g_enabled = true;
+  }
+
+  void stop() {
+    g_enabled = false;
+  }
+
+  bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+  }
+
+  string path() {
+    std::lock_guard<std::mutex> guard(g_lock);
+    return g_path;
+  }
+
+  string to_json() {
+    std::lock_guard<std::mutex> guard(g_lock);
+
+    string pid = to_string(getpid());
+    string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    // Once the buffer has wrapped around, the oldest event is the next one to be overwritten
+    size_t first = g_events.size() < g_capacity ? 0 : g_next;
+
+    for (size_t i = 0; i < g_events.size(); i++) {
+      const auto& e = g_events[(first + i) % g_events.size()];
+
+      if (i > 0) {
+        json += ",";
+      }
+
+      json += "{\"name\":\"" + perf_util::json_escape(e.name) + "\",\"cat\":\"polybar\",\"ph\":\"";
+      json += e.phase;
+      json += "\",\"ts\":" + to_string(e.ts);
+      if (e.phase == 'X') {
+        json += ",\"dur\":" + to_string(e.dur);
+      } else {
+        json += ",\"s\":\"t\"";
+      }
+      json += ",\"pid\":" + pid + ",\"tid\":" + to_string(e.tid) + "}";
+    }
+
+    return json + "]}";
+  }
+
+  string dump() {
+    string file = path();
+    file_util::write_contents(file, to_json());
+    return file;
+  }
+
+  void instant(const char* name, const string& detail) {
+    if (enabled()) {
+      record(event{event_name(name, detail), 'i', now(), 0, thread_id()});
+    }
+  }
+
+  span::span(const char* name, const string& detail) : m_enabled(enabled()) {
+    if (m_enabled) {
+      m_name = event_name(name, detail);
+      m_start = now();
+    }
+  }
+
+  span::~span() {
+    if (m_enabled) {
+      record(event{std::move(m_name), 'X', m_start, now() - m_start, thread_id()});
+    }
+  }
+} // namespace trace_util
+
+POLYBAR_NS_END
@@ -0,0 +1,32 @@
+#include "utils/wakeup_fd.hpp"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "errors.hpp"
+
+POLYBAR_NS
+
+wakeup_fd::wakeup_fd() : m_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  if (m_fd == -1) {
+    throw system_error("Failed to create eventfd");
+  }
+}
+
+bool wakeup_fd::notify() {
+  uint64_t value = 1;
+  return write(m_fd, &value, sizeof(value)) != -1;
+}
+
+void wakeup_fd::drain() {
+  // Reading resets the counter, no matter how often notify() was called
+  uint64_t value;
+  while (read(m_fd, &value, sizeof(value)) == -1 && errno == EINTR) {
+  }
+}
+
+int wakeup_fd::fd() const {
+  return m_fd;
+}
+
+POLYBAR_NS_END
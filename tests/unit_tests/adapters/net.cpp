@@ -0,0 +1,406 @@
+#include "adapters/net.hpp"
+
+#include <arpa/inet.h>
+#include <linux/if.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+using namespace net;
+
+namespace {
+  /**
+   * Builds rtnetlink messages the way the kernel lays them out
+   */
+  class message_buffer {
+   public:
+    template <typename T>
+    void add(uint16_t type, const T& payload, uint32_t sequence = 0, uint16_t flags = 0) {
+      m_start = m_data.size();
+      m_data.resize(m_start + NLMSG_LENGTH(sizeof(T)));
+      struct nlmsghdr header {};
+      header.nlmsg_type = type;
+      header.nlmsg_seq = sequence;
+      header.nlmsg_flags = flags;
+      memcpy(&m_data[m_start], &header, sizeof(header));
+      memcpy(&m_data[m_start + NLMSG_HDRLEN], &payload, sizeof(T));
+      pad();
+    }
+
+    void attribute(uint16_t type, const void* data, size_t size) {
+      size_t offset = m_data.size();
+      m_data.resize(offset + RTA_LENGTH(size));
+      struct rtattr attr {};
+      attr.rta_type = type;
+      attr.rta_len = RTA_LENGTH(size);
+      memcpy(&m_data[offset], &attr, sizeof(attr));
+      memcpy(&m_data[offset + RTA_LENGTH(0)], data, size);
+      pad();
+    }
+
+    void attribute(uint16_t type, const string& value) {
+      attribute(type, value.c_str(), value.size() + 1);
+    }
+
+    const void* data() const {
+      return m_data.data();
+    }
+
+    size_t size() const {
+      return m_data.size();
+    }
+
+    const struct nlmsghdr* message(size_t offset = 0) const {
+      return reinterpret_cast<const struct nlmsghdr*>(&m_data[offset]);
+    }
+
+   private:
+    void pad() {
+      m_data.resize(NLMSG_ALIGN(m_data.size()));
+      auto header = reinterpret_cast<struct nlmsghdr*>(&m_data[m_start]);
+      header->nlmsg_len = m_data.size() - m_start;
+    }
+
+    vector<char> m_data;
+    size_t m_start{0};
+  };
+
+  struct ifinfomsg make_link(int index) {
+    struct ifinfomsg info {};
+    info.ifi_family = AF_UNSPEC;
+    info.ifi_index = index;
+    return info;
+  }
+
+  struct ifaddrmsg make_addr(unsigned char family, unsigned int index) {
+    struct ifaddrmsg info {};
+    info.ifa_family = family;
+    info.ifa_index = index;
+    return info;
+  }
+
+  /**
+   * Local UDP socket that receives the probes of a connectivity_check
+   */
+  class udp_server {
+   public:
+    udp_server() : m_fd(socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) {
+      struct sockaddr_in addr {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      bind(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+      socklen_t len = sizeof(addr);
+      getsockname(m_fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+      m_port = ntohs(addr.sin_port);
+
+      struct timeval timeout {};
+      timeout.tv_sec = 1;
+      setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~udp_server() {
+      close(m_fd);
+    }
+
+    uint16_t port() const {
+      return m_port;
+    }
+
+    /**
+     * Waits for a probe and remembers where it came from
+     */
+    bool receive() {
+      struct sockaddr_in from {};
+      socklen_t len = sizeof(from);
+      char buffer[512];
+      auto bytes = recvfrom(m_fd, buffer, sizeof(buffer), 0, reinterpret_cast<struct sockaddr*>(&from), &len);
+      if (bytes <= 0) {
+        return false;
+      }
+      m_probes.emplace_back(buffer, bytes);
+      m_client = from;
+      return true;
+    }
+
+    /**
+     * Echoes the n-th received probe back
+     */
+    void reply(size_t n) {
+      const auto& probe = m_probes.at(n);
+      sendto(m_fd, probe.data(), probe.size(), 0, reinterpret_cast<struct sockaddr*>(&m_client), sizeof(m_client));
+    }
+
+   private:
+    int m_fd;
+    uint16_t m_port{0};
+    struct sockaddr_in m_client {};
+    vector<string> m_probes;
+  };
+
+  /**
+   * Calls process() whenever it is due until the check finishes
+   */
+  void finish(connectivity_check& check) {
+    for (int i = 0; i < 100 && check.running(); i++) {
+      auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+          check.deadline() - connectivity_check::clock::now());
+      struct pollfd fd {};
+      fd.fd = check.fd();
+      fd.events = POLLIN;
+      poll(&fd, 1, std::max<int>(timeout.count(), 0) + 1);
+      check.process();
+    }
+  }
+
+  /**
+   * Waits until a reply can be read and processes it
+   */
+  bool process_reply(connectivity_check& check) {
+    struct pollfd fd {};
+    fd.fd = check.fd();
+    fd.events = POLLIN;
+    poll(&fd, 1, 1000);
+    return check.process();
+  }
+}  // namespace
+
+TEST(ConnectivityCheck, reply) {
+  udp_server server;
+  connectivity_check check("lo", "127.0.0.1", server.port(), 500ms);
+
+  check.start();
+  ASSERT_TRUE(check.running());
+  ASSERT_TRUE(server.receive());
+  server.reply(0);
+
+  EXPECT_TRUE(process_reply(check));
+  EXPECT_FALSE(check.running());
+  EXPECT_TRUE(check.reachable());
+}
+
+TEST(ConnectivityCheck, timeout) {
+  udp_server server;
+  connectivity_check check("lo", "127.0.0.1", server.port(), 50ms);
+
+  auto start = connectivity_check::clock::now();
+  check.start();
+  finish(check);
+
+  EXPECT_FALSE(check.running());
+  EXPECT_FALSE(check.reachable());
+  EXPECT_GE(connectivity_check::clock::now() - start, 150ms);
+
+  // Both probes were sent
+  EXPECT_TRUE(server.receive());
+  EXPECT_TRUE(server.receive());
+}
+
+TEST(ConnectivityCheck, lateReply) {
+  udp_server server;
+  connectivity_check check("lo", "127.0.0.1", server.port(), 50ms);
+
+  check.start();
+  finish(check);
+  ASSERT_FALSE(check.reachable());
+  ASSERT_TRUE(server.receive());
+  ASSERT_TRUE(server.receive());
+
+  check.start();
+  ASSERT_TRUE(server.receive());
+
+  // Replies to the probes of the first check don't count
+  server.reply(0);
+  server.reply(1);
+  EXPECT_FALSE(process_reply(check));
+  EXPECT_TRUE(check.running());
+
+  server.reply(2);
+  EXPECT_TRUE(process_reply(check));
+  EXPECT_TRUE(check.reachable());
+}
+
+TEST(ConnectivityCheck, refused) {
+  uint16_t port;
+  {
+    // Nothing listens on this port anymore
+    udp_server server;
+    port = server.port();
+  }
+
+  connectivity_check check("lo", "127.0.0.1", port, 500ms);
+  check.start();
+
+  // The ICMP error shows that the host is reachable
+  EXPECT_TRUE(process_reply(check));
+  EXPECT_TRUE(check.reachable());
+}
+
+TEST(Rtnl, linkEvents) {
+  unsigned int ifindex = 2;
+  bool link_changed = false;
+  bool addresses_changed = false;
+
+  message_buffer other;
+  other.add(RTM_NEWLINK, make_link(3));
+  other.attribute(IFLA_IFNAME, "eth1");
+  other.add(RTM_NEWADDR, make_addr(AF_INET, 3));
+  EXPECT_FALSE(rtnl::parse_events(other.data(), other.size(), "eth0", ifindex, link_changed, addresses_changed));
+  EXPECT_FALSE(link_changed);
+  EXPECT_FALSE(addresses_changed);
+
+  message_buffer link;
+  link.add(RTM_NEWLINK, make_link(2));
+  link.attribute(IFLA_IFNAME, "eth0");
+  EXPECT_TRUE(rtnl::parse_events(link.data(), link.size(), "eth0", ifindex, link_changed, addresses_changed));
+  EXPECT_TRUE(link_changed);
+  EXPECT_FALSE(addresses_changed);
+
+  link_changed = false;
+  message_buffer addr;
+  addr.add(RTM_DELADDR, make_addr(AF_INET6, 2));
+  EXPECT_TRUE(rtnl::parse_events(addr.data(), addr.size(), "eth0", ifindex, link_changed, addresses_changed));
+  EXPECT_FALSE(link_changed);
+  EXPECT_TRUE(addresses_changed);
+}
+
+TEST(Rtnl, recreatedInterface) {
+  unsigned int ifindex = 2;
+  bool link_changed = false;
+  bool addresses_changed = false;
+
+  message_buffer buffer;
+  buffer.add(RTM_DELLINK, make_link(2));
+  buffer.attribute(IFLA_IFNAME, "eth0");
+  buffer.add(RTM_NEWLINK, make_link(7));
+  buffer.attribute(IFLA_IFNAME, "eth0");
+
+  EXPECT_TRUE(rtnl::parse_events(buffer.data(), buffer.size(), "eth0", ifindex, link_changed, addresses_changed));
+  EXPECT_EQ(7, ifindex);
+  EXPECT_TRUE(link_changed);
+  EXPECT_TRUE(addresses_changed);
+}
+
+TEST(Rtnl, response) {
+  vector<int> indices;
+  auto callback = [&](const struct nlmsghdr* msg) {
+    indices.push_back(static_cast<const struct ifinfomsg*>(NLMSG_DATA(msg))->ifi_index);
+  };
+
+  message_buffer first;
+  first.add(RTM_NEWLINK, make_link(1), 4);
+  first.add(RTM_NEWLINK, make_link(2), 5, NLM_F_MULTI);
+  first.add(RTM_NEWLINK, make_link(3), 5, NLM_F_MULTI);
+  EXPECT_EQ(-1, rtnl::parse_response(first.data(), first.size(), 5, callback));
+
+  message_buffer second;
+  second.add(RTM_NEWLINK, make_link(4), 5, NLM_F_MULTI);
+  second.add(NLMSG_DONE, 0, 5, NLM_F_MULTI);
+  second.add(RTM_NEWLINK, make_link(5), 5, NLM_F_MULTI);
+  EXPECT_EQ(0, rtnl::parse_response(second.data(), second.size(), 5, callback));
+
+  EXPECT_EQ((vector<int>{2, 3, 4}), indices);
+
+  // Responses to requests without NLM_F_DUMP consist of a single message
+  message_buffer single;
+  single.add(RTM_NEWLINK, make_link(6), 6);
+  single.add(RTM_NEWLINK, make_link(7), 6);
+  EXPECT_EQ(0, rtnl::parse_response(single.data(), single.size(), 6, callback));
+  EXPECT_EQ((vector<int>{2, 3, 4, 6}), indices);
+}
+
+TEST(Rtnl, error) {
+  struct nlmsgerr err {};
+  err.error = -ENODEV;
+
+  message_buffer buffer;
+  buffer.add(NLMSG_ERROR, err, 3);
+  EXPECT_EQ(ENODEV, rtnl::parse_response(buffer.data(), buffer.size(), 3, [](const struct nlmsghdr*) { FAIL(); }));
+}
+
+TEST(Rtnl, stats) {
+  struct rtnl_link_stats64 stats {};
+  stats.tx_bytes = 100;
+  stats.rx_bytes = 2000;
+
+  struct if_stats_msg msg {};
+  message_buffer buffer;
+  buffer.add(RTM_NEWSTATS, msg);
+  buffer.attribute(IFLA_STATS_LINK_64, &stats, sizeof(stats));
+  // Too short to hold the counters
+  buffer.attribute(IFLA_STATS_LINK_64, &stats, 8);
+
+  link_activity activity{};
+  activity.transmitted = 1;
+  rtnl::parse_stats(buffer.message(), activity);
+  EXPECT_EQ(101, activity.transmitted);
+  EXPECT_EQ(2000, activity.received);
+}
+
+TEST(Rtnl, link) {
+  const unsigned char mac[] = {0x00, 0x11, 0x22, 0xaa, 0xbb, 0xcc};
+  const unsigned char operstate = IF_OPER_UP;
+
+  message_buffer buffer;
+  buffer.add(RTM_NEWLINK, make_link(2));
+  buffer.attribute(IFLA_IFNAME, "eth0");
+  buffer.attribute(IFLA_ADDRESS, mac, sizeof(mac));
+  buffer.attribute(IFLA_OPERSTATE, &operstate, sizeof(operstate));
+
+  unsigned char state = IF_OPER_NOTPRESENT;
+  string address = "N/A";
+  rtnl::parse_link(buffer.message(), state, address);
+  EXPECT_EQ(IF_OPER_UP, state);
+  EXPECT_EQ("00:11:22:aa:bb:cc", address);
+}
+
+TEST(Rtnl, address) {
+  struct in_addr local, peer;
+  inet_pton(AF_INET, "10.0.0.2", &local);
+  inet_pton(AF_INET, "10.0.0.1", &peer);
+
+  string ip = "N/A";
+  string ip6 = "N/A";
+
+  message_buffer other;
+  other.add(RTM_NEWADDR, make_addr(AF_INET, 3));
+  other.attribute(IFA_ADDRESS, &peer, sizeof(peer));
+  rtnl::parse_address(other.message(), 2, ip, ip6);
+  EXPECT_EQ("N/A", ip);
+
+  message_buffer v4;
+  v4.add(RTM_NEWADDR, make_addr(AF_INET, 2));
+  v4.attribute(IFA_ADDRESS, &peer, sizeof(peer));
+  v4.attribute(IFA_LOCAL, &local, sizeof(local));
+  rtnl::parse_address(v4.message(), 2, ip, ip6);
+  EXPECT_EQ("10.0.0.2", ip);
+  EXPECT_EQ("N/A", ip6);
+
+  for (auto skipped : {"fe80::1", "fec0::1", "fd00::1"}) {
+    struct in6_addr addr;
+    inet_pton(AF_INET6, skipped, &addr);
+    message_buffer v6;
+    v6.add(RTM_NEWADDR, make_addr(AF_INET6, 2));
+    v6.attribute(IFA_ADDRESS, &addr, sizeof(addr));
+    rtnl::parse_address(v6.message(), 2, ip, ip6);
+    EXPECT_EQ("N/A", ip6) << skipped;
+  }
+
+  struct in6_addr global;
+  inet_pton(AF_INET6, "2001:db8::1", &global);
+  message_buffer v6;
+  v6.add(RTM_NEWADDR, make_addr(AF_INET6, 2));
+  v6.attribute(IFA_ADDRESS, &global, sizeof(global));
+  rtnl::parse_address(v6.message(), 2, ip, ip6);
+  EXPECT_EQ("2001:db8::1", ip6);
+}
@@ -0,0 +1,145 @@
+#include "adapters/script_runner.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+using namespace std::chrono_literals;
+
+/**
+ * Runs scripts in the given mode and records every update
+ */
+template <script_runner::mode Mode>
+class ScriptRunner : public ::testing::Test {
+ protected:
+  unique_ptr<script_runner> make_runner(const string& exec) {
+    return make_unique<script_runner>([this](const script_runner::data& data) { updates.push_back(data); }, exec, "",
+        Mode, 0s, 0s, 1s, vector<pair<string, string>>{});
+  }
+
+  vector<script_runner::data> updates;
+};
+
+using Coprocess = ScriptRunner<script_runner::mode::COPROCESS>;
+using Tail = ScriptRunner<script_runner::mode::TAIL>;
+
+TEST_F(Coprocess, keeps_running) {
+  auto runner = make_runner("while read n; do echo \"$n $$\"; done");
+
+  runner->process();
+  runner->process();
+
+  ASSERT_EQ(2, updates.size());
+  EXPECT_EQ(0, updates[1].exit_status);
+  EXPECT_EQ(updates[0].pid, updates[1].pid);
+  EXPECT_EQ("1 " + to_string(updates[0].pid), updates[0].output);
+  EXPECT_EQ("2 " + to_string(updates[0].pid), updates[1].output);
+
+  runner->stop();
+}
+
+TEST_F(Coprocess, restart) {
+  auto runner = make_runner("read n; echo $n; exit 3");
+
+  EXPECT_EQ(script_runner::interval{0s}, runner->process());
+  ASSERT_EQ(1, updates.size());
+  EXPECT_EQ("1", updates[0].output);
+
+  // Exited instead of answering, the next request is not even written
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(script_runner::interval{1s}, runner->process());
+  ASSERT_EQ(2, updates.size());
+  EXPECT_EQ(3, updates[1].exit_status);
+  EXPECT_EQ(-1, updates[1].pid);
+
+  runner->process();
+  ASSERT_EQ(3, updates.size());
+  EXPECT_EQ(0, updates[2].exit_status);
+  EXPECT_EQ("3", updates[2].output);
+}
+
+TEST_F(Coprocess, timeout) {
+  auto runner = make_runner("while read n; do sleep 10; done");
+
+  EXPECT_EQ(script_runner::interval{1s}, runner->process());
+  ASSERT_EQ(1, updates.size());
+  EXPECT_NE(0, updates[0].exit_status);
+}
+
+TEST_F(Coprocess, partial_line) {
+  auto runner = make_runner("while read n; do printf \"$n \"; sleep 0.1; echo done; done");
+
+  runner->process();
+  runner->process();
+
+  ASSERT_EQ(2, updates.size());
+  EXPECT_EQ("1 done", updates[0].output);
+  EXPECT_EQ("2 done", updates[1].output);
+}
+
+TEST_F(Coprocess, extra_lines) {
+  auto runner = make_runner("while read n; do echo \"$n a\"; echo \"$n b\" >&2; echo \"$n c\"; done");
+
+  runner->process();
+  std::this_thread::sleep_for(100ms);
+  runner->process();
+
+  // The second line of each reply is dropped, stderr is discarded
+  ASSERT_EQ(2, updates.size());
+  EXPECT_EQ("1 a", updates[0].output);
+  EXPECT_EQ("2 a", updates[1].output);
+}
+
+TEST_F(Coprocess, long_line) {
+  auto runner = make_runner("while read n; do head -c 200000 /dev/zero | tr '\\0' a; echo; done");
+
+  runner->process();
+
+  // Cut off after 64 KiB
+  ASSERT_EQ(1, updates.size());
+  EXPECT_EQ(string(64 * 1024, 'a'), updates[0].output);
+}
+
+TEST_F(Tail, coalesce) {
+  auto runner = make_runner("printf 'a\\nb\\nc\\n'; sleep 0.1; printf 'd\\ne'; sleep 0.1");
+
+  EXPECT_EQ(script_runner::interval{0s}, runner->process());
+
+  // Last line of each burst, the partial line once the output is closed and the pid reset
+  ASSERT_EQ(4, updates.size());
+  EXPECT_EQ("c", updates[0].output);
+  EXPECT_EQ("d", updates[1].output);
+  EXPECT_EQ("e", updates[2].output);
+  EXPECT_EQ(-1, updates[3].pid);
+}
+
+TEST_F(Tail, long_line) {
+  auto runner = make_runner(
+      "head -c 200000 /dev/zero | tr '\\0' a; sleep 0.1; head -c 200000 /dev/zero | tr '\\0' b; echo");
+
+  runner->process();
+
+  // Cut off after 64 KiB, the rest of the line is dropped instead of buffered
+  ASSERT_EQ(2, updates.size());
+  EXPECT_EQ(string(64 * 1024, 'a'), updates[0].output);
+  EXPECT_EQ(-1, updates[1].pid);
+}
+
+TEST_F(Tail, stop) {
+  auto runner = make_runner("echo running; sleep 10");
+
+  std::thread stopper([&] {
+    std::this_thread::sleep_for(100ms);
+    runner->stop();
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  runner->process();
+  stopper.join();
+
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+  ASSERT_FALSE(updates.empty());
+  EXPECT_EQ("running", updates[0].output);
+}
@@ -0,0 +1,90 @@
+#include "cairo/font_cache.hpp"
+
+#include <unistd.h>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+using namespace cairo;
+
+class FontCache : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    unlink(path.c_str());
+  }
+
+  string path = "/tmp/polybar-test-fonts." + to_string(getpid());
+};
+
+TEST(FontCacheCharset, add) {
+  font_cache::charset chars;
+  for (uint32_t c : {0x20, 0x21, 0x22, 0x41, 0x1F600, 0x1F601}) {
+    font_cache::add(chars, c);
+  }
+
+  font_cache::charset expected{{0x20, 0x22}, {0x41, 0x41}, {0x1F600, 0x1F601}};
+  EXPECT_EQ(expected, chars);
+}
+
+TEST(FontCacheCharset, contains) {
+  font_cache::charset chars{{0x20, 0x7e}, {0xa0, 0xa0}, {0x100, 0x17f}};
+
+  EXPECT_TRUE(font_cache::contains(chars, 0x20));
+  EXPECT_TRUE(font_cache::contains(chars, 0x41));
+  EXPECT_TRUE(font_cache::contains(chars, 0x7e));
+  EXPECT_TRUE(font_cache::contains(chars, 0xa0));
+  EXPECT_TRUE(font_cache::contains(chars, 0x17f));
+
+  EXPECT_FALSE(font_cache::contains(chars, 0x1f));
+  EXPECT_FALSE(font_cache::contains(chars, 0x7f));
+  EXPECT_FALSE(font_cache::contains(chars, 0xa1));
+  EXPECT_FALSE(font_cache::contains(chars, 0x180));
+  EXPECT_FALSE(font_cache::contains({}, 0x41));
+}
+
+TEST_F(FontCache, roundTrip) {
+  auto key = font_cache::key("Noto Sans:size=10", 96, 96);
+
+  {
+    font_cache cache(path, "gen1");
+    EXPECT_EQ(nullptr, cache.find(key));
+    cache.insert(key, {"Noto Sans:file=/usr/share/fonts/noto.ttf", {{0x20, 0x7e}, {0xa0, 0xa0}}});
+    cache.save();
+  }
+
+  font_cache cache(path, "gen1");
+  auto entry = cache.find(key);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("Noto Sans:file=/usr/share/fonts/noto.ttf", entry->pattern);
+  font_cache::charset expected{{0x20, 0x7e}, {0xa0, 0xa0}};
+  EXPECT_EQ(expected, entry->chars);
+
+  EXPECT_EQ(nullptr, cache.find(font_cache::key("Noto Sans:size=10", 120, 120)));
+}
+
+TEST_F(FontCache, generationMismatch) {
+  {
+    font_cache cache(path, "gen1");
+    cache.insert("font", {"pattern", {{0x20, 0x7e}}});
+    cache.save();
+  }
+
+  font_cache cache(path, "gen2");
+  EXPECT_EQ(nullptr, cache.find("font"));
+}
+
+TEST_F(FontCache, rejectsSeparators) {
+  font_cache cache(path, "gen1");
+  cache.insert("a\tb", {"pattern", {}});
+  cache.insert("font", {"a\nb", {}});
+
+  EXPECT_EQ(nullptr, cache.find("a\tb"));
+  EXPECT_EQ(nullptr, cache.find("font"));
+}
+
+TEST(FontCacheNoPath, neverWrites) {
+  font_cache cache("", "gen1");
+  cache.insert("font", {"pattern", {}});
+  EXPECT_NO_THROW(cache.save());
+  EXPECT_NE(nullptr, cache.find("font"));
+}
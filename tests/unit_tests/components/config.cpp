@@ -0,0 +1,156 @@
+#include "components/config.hpp"
+
+#include <unistd.h>
+
+#include "common/test.hpp"
+#include "components/logger.hpp"
+#include "utils/file.hpp"
+
+using namespace polybar;
+
+class Config : public ::testing::Test {
+ protected:
+  unique_ptr<config> make_config(sectionmap_t sections) {
+    auto conf = make_unique<config>(l, "/dev/null", "example");
+    conf->set_sections(move(sections));
+    conf->resolve();
+    return conf;
+  }
+
+  const logger l = logger(loglevel::NONE);
+};
+
+TEST_F(Config, referenceChain) {
+  auto conf = make_config({{"bar/example", {{"a", "${self.b}"}, {"b", "${module/c.c}"}, {"d", "${root.a}"}}},
+      {"module/c", {{"c", "${root.e}"}}}, {"colors", {{"fg", "${module/c.c}"}}}});
+
+  EXPECT_THROW(conf->get("bar/example", "a"), value_error);
+
+  conf = make_config({{"bar/example", {{"a", "${self.b}"}, {"b", "${module/c.c}"}, {"d", "${root.a}"}}},
+      {"module/c", {{"c", "${root.e:foo}"}}}, {"colors", {{"fg", "${module/c.c}"}}}});
+
+  for (const auto& key : {"a", "b", "d"}) {
+    EXPECT_EQ("foo", conf->get("bar/example", key));
+  }
+  EXPECT_EQ("foo", conf->get("module/c", "c"));
+  EXPECT_EQ("foo", conf->get("colors", "fg"));
+}
+
+TEST_F(Config, referenceCycle) {
+  auto conf = make_config({{"bar/example", {{"a", "${self.b}"}, {"b", "${colors.fg}"}, {"c", "${root.a}"}, {"d", "ok"}}},
+      {"colors", {{"fg", "${root.a}"}, {"self", "${self.self}"}}}});
+
+  for (const auto& key : {"a", "b", "c"}) {
+    EXPECT_THROW(conf->get("bar/example", key), value_error);
+  }
+  EXPECT_THROW(conf->get("colors", "fg"), value_error);
+  EXPECT_THROW(conf->get("colors", "self"), value_error);
+  EXPECT_EQ("ok", conf->get("bar/example", "d"));
+}
+
+TEST_F(Config, handle) {
+  auto conf = make_config({{"bar/example", {{"a", "${self.b}"}, {"b", "42"}}}, {"module/c", {{"c", "foo"}}}});
+
+  auto a = conf->handle("bar/example", "a");
+  EXPECT_EQ("42", conf->get(a));
+  EXPECT_EQ("foo", conf->get(conf->handle("module/c", "c")));
+  EXPECT_EQ(conf->get<int>("bar/example", "b"), conf->get<int>(a));
+}
+
+TEST_F(Config, handleMissing) {
+  auto conf = make_config({{"bar/example", {{"a", "foo"}}}});
+
+  EXPECT_THROW(conf->handle("bar/example", "b"), key_error);
+  EXPECT_THROW(conf->handle("module/c", "a"), key_error);
+  EXPECT_THROW(conf->get("bar/example", "b"), key_error);
+  EXPECT_EQ("bar", conf->get<string>("bar/example", "b", "bar"));
+}
+
+TEST_F(Config, cachedConversion) {
+  auto conf = make_config({{"bar/example", {{"a", "3.5"}}}});
+  auto a = conf->handle("bar/example", "a");
+
+  // Each type is converted and cached separately
+  EXPECT_EQ(3, conf->get<int>(a));
+  EXPECT_EQ(3.5, conf->get<double>(a));
+  EXPECT_EQ(3, conf->get<int>(a));
+  EXPECT_EQ(3.5, conf->get<double>(a));
+  EXPECT_EQ("3.5", conf->get(a));
+}
+
+TEST_F(Config, failedEntry) {
+  auto conf = make_config({{"bar/example", {{"a", "${self.missing}"}, {"b", "${self.a}"}}}});
+  auto a = conf->handle("bar/example", "a");
+
+  // The error is stored in the snapshot and rethrown on every access
+  EXPECT_THROW(conf->get(a), value_error);
+  EXPECT_THROW(conf->get<int>(a), value_error);
+  EXPECT_THROW(conf->get("bar/example", "b"), value_error);
+  EXPECT_EQ(1, conf->get<int>("bar/example", "a", 1));
+}
+
+TEST_F(Config, refreshFileReference) {
+  string path = "/tmp/polybar-test-reference." + to_string(getpid());
+  file_util::write_contents(path, "foo\n");
+
+  auto conf = make_config({{"bar/example", {{"a", "${file:" + path + "}"}, {"b", "${self.a}"}, {"c", "bar"}}},
+      {"module/a", {{"label", "${file:" + path + ":fallback}"}}}});
+
+  EXPECT_EQ("foo", conf->get("bar/example", "b"));
+  EXPECT_EQ("foo", conf->get("module/a", "label"));
+  EXPECT_EQ(file_list{path}, conf->get_referenced_files());
+  EXPECT_FALSE(conf->has_xrdb_references());
+
+  file_util::write_contents(path, "baz\n");
+  EXPECT_EQ("foo", conf->get("bar/example", "a"));
+
+  auto unchanged = conf->refresh({}, false);
+  EXPECT_EQ("foo", unchanged.get("bar/example", "b"));
+  EXPECT_TRUE(unchanged.section_equals("module/a", *conf));
+
+  auto changed = conf->refresh({path}, false);
+  EXPECT_EQ("baz", changed.get("bar/example", "a"));
+  EXPECT_EQ("baz", changed.get("bar/example", "b"));
+  EXPECT_EQ("bar", changed.get("bar/example", "c"));
+  EXPECT_FALSE(changed.section_equals("module/a", *conf));
+
+  unlink(path.c_str());
+  auto removed = changed.refresh({path}, false);
+  EXPECT_THROW(removed.get("bar/example", "a"), value_error);
+  EXPECT_EQ("fallback", removed.get("module/a", "label"));
+}
+
+TEST_F(Config, identical) {
+  sectionmap_t sections{{"module/a", {{"type", "custom/text"}, {"format", "foo"}}}};
+  EXPECT_TRUE(make_config(sections)->section_equals("module/a", *make_config(sections)));
+}
+
+TEST_F(Config, changedValue) {
+  auto a = make_config({{"module/a", {{"type", "custom/text"}, {"format", "foo"}}}});
+  auto b = make_config({{"module/a", {{"type", "custom/text"}, {"format", "bar"}}}});
+  EXPECT_FALSE(a->section_equals("module/a", *b));
+}
+
+TEST_F(Config, addedKey) {
+  auto a = make_config({{"module/a", {{"type", "custom/text"}}}});
+  auto b = make_config({{"module/a", {{"type", "custom/text"}, {"format", "foo"}}}});
+  EXPECT_FALSE(a->section_equals("module/a", *b));
+  EXPECT_FALSE(b->section_equals("module/a", *a));
+}
+
+TEST_F(Config, missingSection) {
+  auto a = make_config({{"module/a", {{"type", "custom/text"}}}});
+  auto b = make_config({});
+  EXPECT_FALSE(a->section_equals("module/a", *b));
+  EXPECT_TRUE(a->section_equals("module/b", *b));
+}
+
+TEST_F(Config, changedReference) {
+  auto a = make_config({{"colors", {{"fg", "#fff"}}}, {"module/a", {{"format-foreground", "${colors.fg}"}}}});
+  auto b = make_config({{"colors", {{"fg", "#000"}}}, {"module/a", {{"format-foreground", "${colors.fg}"}}}});
+  auto c = make_config({{"colors", {{"fg", "#fff"}, {"bg", "#000"}}}, {"module/a", {{"format-foreground", "${colors.fg}"}}}});
+
+  EXPECT_FALSE(a->section_equals("module/a", *b));
+  EXPECT_TRUE(a->section_equals("module/a", *c));
+  EXPECT_FALSE(a->section_equals("colors", *c));
+}
@@ -1,7 +1,11 @@
 #include "components/config_parser.hpp"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "common/test.hpp"
 #include "components/logger.hpp"
+#include "utils/file.hpp"
 
 using namespace polybar;
 using namespace std;
@@ -312,3 +316,68 @@ TEST_P(ParseEscapedValueTest, correctness) {
   EXPECT_EQ(GetParam().first, value);
 }
 // }}}
+
+// ParseIncludesTest {{{
+class ParseIncludesTest : public ConfigParser {
+ protected:
+  void SetUp() override {
+    mkdir(dir.c_str(), 0700);
+    mkdir((dir + "/conf.d").c_str(), 0700);
+  }
+
+  void TearDown() override {
+    for (const auto& file : files) {
+      unlink(file.c_str());
+    }
+    rmdir((dir + "/conf.d").c_str());
+    rmdir(dir.c_str());
+  }
+
+  string write(const string& name, const string& contents) {
+    files.push_back(dir + "/" + name);
+    file_util::write_contents(files.back(), contents);
+    return files.back();
+  }
+
+  const string dir = "/tmp/polybar-test-config." + to_string(getpid());
+  vector<string> files;
+};
+
+/**
+ * Included lines take the place of the include line, even if they switch the
+ * section
+ */
+TEST_F(ParseIncludesTest, order) {
+  write("conf.d/b.ini", "b = 2\n");
+  write("conf.d/a.ini", "a = 1\n");
+  write("other.ini", "[section/other]\nfoo = bar\n");
+  auto main = write("main.ini",
+      "[bar/main]\n"
+      "include-directory = conf.d\n"
+      "c = 3\n"
+      "include-file = other.ini\n"
+      "d = 4");
+
+  config conf = config_parser(l, string(main)).parse("main");
+
+  EXPECT_EQ("1", conf.get("bar/main", "a"));
+  EXPECT_EQ("2", conf.get("bar/main", "b"));
+  EXPECT_EQ("3", conf.get("bar/main", "c"));
+  EXPECT_EQ("bar", conf.get("section/other", "foo"));
+  EXPECT_EQ("4", conf.get("section/other", "d"));
+  EXPECT_FALSE(conf.has("bar/main", "d"));
+}
+
+TEST_F(ParseIncludesTest, cycle) {
+  write("a.ini", "include-file = main.ini\n");
+  auto main = write("main.ini", "[bar/main]\ninclude-file = a.ini\n");
+
+  EXPECT_THROW(config_parser(l, string(main)).parse("main"), application_error);
+}
+
+TEST_F(ParseIncludesTest, missing) {
+  auto main = write("main.ini", "[bar/main]\ninclude-file = missing.ini\n");
+
+  EXPECT_THROW(config_parser(l, string(main)).parse("main"), application_error);
+}
+// }}}
@@ -47,3 +47,20 @@ TEST(Ramp, weights) {
   EXPECT_EQ("test2", r.get_by_percentage_with_borders(24, 20, 40)->get());
   EXPECT_EQ("test3", r.get_by_percentage_with_borders(25, 20, 40)->get());
 }
+
+TEST(Ramp, table) {
+  for (int icons = 1; icons <= 12; icons++) {
+    ramp r;
+    for (int i = 0; i < icons; i++) {
+      r.add(std::make_shared<label>("test" + to_string(i), 0));
+    }
+
+    for (float max : {1.0f, 40.0f, 80.0f, 100.0f}) {
+      ramp_table table(r, 0.0f, max);
+
+      for (float value = -1.0f; value <= 101.0f; value += 0.125f) {
+        EXPECT_EQ(r.get_by_percentage_with_borders(value, 0.0f, max), table.get(value));
+      }
+    }
+  }
+}
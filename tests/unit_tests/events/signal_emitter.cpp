@@ -0,0 +1,210 @@
+#include "events/signal_emitter.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+namespace {
+  struct ping {
+    int value;
+  };
+  struct pong {};
+
+  template <int Priority>
+  class receiver : public signal_receiver<Priority, ping, pong> {
+   public:
+    explicit receiver(vector<int>& calls, bool consume = false) : m_calls(calls), m_consume(consume) {}
+
+    bool on(const ping& sig) override {
+      m_calls.push_back(Priority * 100 + sig.value);
+      return m_consume;
+    }
+
+    bool on(const pong&) override {
+      pongs++;
+      return false;
+    }
+
+    std::atomic_int pongs{0};
+
+   private:
+    vector<int>& m_calls;
+    bool m_consume;
+  };
+} // namespace
+
+TEST(SignalEmitter, priorityOrder) {
+  signal_emitter sig;
+  vector<int> calls;
+  receiver<2> second(calls);
+  receiver<1> first(calls);
+  receiver<2> third(calls);
+
+  EXPECT_FALSE(sig.emit(ping{1}));
+  EXPECT_TRUE(calls.empty());
+
+  sig.attach(&second);
+  sig.attach(&first);
+  sig.attach(&third);
+
+  EXPECT_FALSE(sig.emit(ping{1}));
+  EXPECT_EQ((vector<int>{101, 201, 201}), calls);
+
+  sig.detach(&second);
+  calls.clear();
+  EXPECT_FALSE(sig.emit(ping{2}));
+  EXPECT_EQ((vector<int>{102, 202}), calls);
+
+  sig.detach(&first);
+  sig.detach(&third);
+  calls.clear();
+  EXPECT_FALSE(sig.emit(ping{3}));
+  EXPECT_TRUE(calls.empty());
+}
+
+TEST(SignalEmitter, consumed) {
+  signal_emitter sig;
+  vector<int> calls;
+  receiver<1> first(calls, true);
+  receiver<2> second(calls);
+
+  sig.attach(&first);
+  sig.attach(&second);
+
+  EXPECT_TRUE(sig.emit(ping{1}));
+  EXPECT_EQ((vector<int>{101}), calls);
+
+  sig.detach(&first);
+  sig.detach(&second);
+}
+
+/**
+ * Emitting from other threads while receivers are attached and detached
+ */
+TEST(SignalEmitter, concurrent) {
+  signal_emitter sig;
+  vector<int> calls;
+  receiver<1> fixed(calls);
+  receiver<2> toggled(calls);
+
+  sig.attach(&fixed);
+
+  std::atomic_bool done{false};
+  vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      while (!done) {
+        sig.emit(pong{});
+      }
+    });
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    sig.attach(&toggled);
+    sig.detach(&toggled);
+  }
+
+  done = true;
+  for (auto&& t : threads) {
+    t.join();
+  }
+
+  EXPECT_GT(fixed.pongs, 0);
+  sig.detach(&fixed);
+}
+
+namespace {
+  /**
+   * Records calls that arrive after it was detached
+   */
+  class detached_receiver : public signal_receiver<1, pong> {
+   public:
+    explicit detached_receiver(std::atomic_bool& detached, std::atomic_int& late_calls)
+        : m_detached(detached), m_late_calls(late_calls) {}
+
+    bool on(const pong&) override {
+      if (m_detached) {
+        m_late_calls++;
+      }
+      return false;
+    }
+
+   private:
+    std::atomic_bool& m_detached;
+    std::atomic_int& m_late_calls;
+  };
+} // namespace
+
+/**
+ * Receivers are destroyed right after detaching while other threads emit
+ */
+TEST(SignalEmitter, detachAndDestroy) {
+  signal_emitter sig;
+  std::atomic_int late_calls{0};
+
+  std::atomic_bool done{false};
+  vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      while (!done) {
+        sig.emit(pong{});
+      }
+    });
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    std::atomic_bool detached{false};
+    auto r = make_unique<detached_receiver>(detached, late_calls);
+    sig.attach(r.get());
+    sig.detach(r.get());
+    detached = true;
+    r.reset();
+  }
+
+  done = true;
+  for (auto&& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(0, late_calls);
+}
+
+namespace {
+  class self_detaching_receiver : public signal_receiver<1, ping> {
+   public:
+    explicit self_detaching_receiver(signal_emitter& sig) : m_sig(sig) {}
+
+    bool on(const ping&) override {
+      calls++;
+      m_sig.detach(this);
+      return false;
+    }
+
+    int calls{0};
+
+   private:
+    signal_emitter& m_sig;
+  };
+} // namespace
+
+TEST(SignalEmitter, detachFromHandler) {
+  signal_emitter sig;
+  vector<int> calls;
+  self_detaching_receiver first(sig);
+  receiver<2> second(calls);
+
+  sig.attach(&first);
+  sig.attach(&second);
+
+  // The running emit still reaches the receivers of the old list
+  sig.emit(ping{1});
+  sig.emit(ping{2});
+
+  EXPECT_EQ(1, first.calls);
+  EXPECT_EQ((vector<int>{201, 202}), calls);
+
+  sig.detach(&second);
+}
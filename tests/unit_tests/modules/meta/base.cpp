@@ -0,0 +1,168 @@
+#include "modules/meta/base.hpp"
+
+#include <future>
+
+#include "common/test.hpp"
+#include "components/config.hpp"
+#include "events/signal.hpp"
+#include "modules/meta/base.inl"
+
+using namespace polybar;
+using namespace modules;
+
+namespace {
+  class test_module : public module<test_module> {
+   public:
+    using module::broadcast;
+    using module::module;
+    using module::set_visible;
+
+    static constexpr auto TYPE = "internal/test";
+
+    string get_output() {
+      std::lock_guard<std::mutex> guard(m_buildlock);
+      return output;
+    }
+
+    /**
+     * Broadcasts until the module is stopped, like an animation thread
+     */
+    void start_broadcasting() {
+      m_threads.emplace_back([this] {
+        while (running()) {
+          broadcast();
+        }
+      });
+    }
+
+    string output;
+  };
+
+  class change_receiver : public signal_receiver<0, signals::eventqueue::notify_change> {
+   public:
+    bool on(const signals::eventqueue::notify_change&) override {
+      changes++;
+      return false;
+    }
+
+    int changes{0};
+  };
+
+  /**
+   * Checks for running modules on check_state, like the controller does
+   */
+  class state_receiver : public signal_receiver<0, signals::eventqueue::check_state> {
+   public:
+    bool on(const signals::eventqueue::check_state&) override {
+      checks++;
+      if (std::none_of(modules.begin(), modules.end(), [](const module_t& m) { return m->running(); })) {
+        idle++;
+      }
+      return false;
+    }
+
+    vector<module_t> modules;
+    int checks{0};
+    int idle{0};
+  };
+} // namespace
+
+class ModuleBroadcast : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    conf.set_sections({{"bar/example", {}}, {"module/test", {}}});
+    conf.resolve();
+    mod = make_unique<test_module>(bar, "test", conf);
+    signal_emitter::make().attach(&receiver);
+  }
+
+  void TearDown() override {
+    signal_emitter::make().detach(&receiver);
+  }
+
+  const logger l{loglevel::NONE};
+  config conf{l, "/dev/null", "example"};
+  bar_settings bar{};
+  change_receiver receiver;
+  unique_ptr<test_module> mod;
+};
+
+TEST_F(ModuleBroadcast, suppressUnchanged) {
+  mod->output = "foo";
+  mod->broadcast();
+  mod->broadcast();
+
+  EXPECT_EQ(1, receiver.changes);
+  EXPECT_EQ(2, mod->stats().broadcasts);
+  EXPECT_EQ(1, mod->stats().suppressed);
+
+  mod->output = "bar";
+  mod->broadcast();
+
+  EXPECT_EQ(2, receiver.changes);
+  EXPECT_EQ(1, mod->stats().suppressed);
+  EXPECT_NE(string::npos, mod->contents().find("bar"));
+}
+
+TEST_F(ModuleBroadcast, hidden) {
+  mod->set_visible(false);
+  receiver.changes = 0;
+
+  mod->output = "foo";
+  mod->broadcast();
+
+  // Neither forwarded nor counted as unchanged output
+  EXPECT_EQ(0, receiver.changes);
+  EXPECT_EQ(0, mod->stats().suppressed);
+
+  mod->set_visible(true);
+  EXPECT_EQ(1, receiver.changes);
+  EXPECT_NE(string::npos, mod->contents().find("foo"));
+}
+
+TEST_F(ModuleBroadcast, stopWhileBroadcasting) {
+  mod->output = "foo";
+  mod->start();
+  mod->start_broadcasting();
+
+  auto stopped = std::async(std::launch::async, [&] {
+    mod->stop();
+    mod->join();
+  });
+
+  ASSERT_EQ(std::future_status::ready, stopped.wait_for(std::chrono::seconds(5)));
+  EXPECT_FALSE(mod->running());
+}
+
+TEST_F(ModuleBroadcast, replaceOnlyModule) {
+  state_receiver states;
+  signal_emitter::make().attach(&states);
+
+  module_t old = std::move(mod);
+  old->start();
+  states.modules = {old};
+
+  auto module = make_shared<test_module>(bar, "test", conf);
+  module->start();
+  replace_module(old, module, {&states.modules});
+  signal_emitter::make().detach(&states);
+
+  ASSERT_EQ(1, states.modules.size());
+  EXPECT_EQ(module, states.modules[0]);
+  EXPECT_FALSE(old->running());
+  EXPECT_EQ(1, states.checks);
+  EXPECT_EQ(0, states.idle);
+}
+
+TEST_F(ModuleBroadcast, removeFailedModule) {
+  module_t old = std::move(mod);
+  old->start();
+  vector<module_t> modules{old};
+  vector<module_t> block{old};
+
+  replace_module(old, nullptr, {&modules, &block});
+
+  EXPECT_TRUE(modules.empty());
+  EXPECT_TRUE(block.empty());
+  EXPECT_FALSE(old->running());
+}
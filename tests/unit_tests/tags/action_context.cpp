@@ -137,6 +137,35 @@ TEST(ActionCtxtTest, stacking) {
   EXPECT_EQ(0, ctxt.num_unclosed());
 }
 
+TEST(ActionCtxtTest, alignmentStart) {
+  action_context ctxt;
+
+  auto id1 = ctxt.action_open(mousebtn::LEFT, "", alignment::LEFT, 0);
+  ctxt.action_close(mousebtn::LEFT, alignment::LEFT, 2);
+  auto id2 = ctxt.action_open(mousebtn::LEFT, "", alignment::RIGHT, 0);
+  ctxt.action_close(mousebtn::LEFT, alignment::RIGHT, 2);
+
+  ctxt.set_alignment_start(alignment::RIGHT, 10);
+
+  EXPECT_EQ(id1, ctxt.has_action(mousebtn::LEFT, 1));
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::LEFT, 2));
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::LEFT, 9));
+  EXPECT_EQ(id2, ctxt.has_action(mousebtn::LEFT, 10));
+  EXPECT_EQ(id2, ctxt.has_action(mousebtn::LEFT, 11));
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::LEFT, 12));
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::RIGHT, 1));
+
+  // Moving the alignment must be picked up by subsequent lookups
+  ctxt.set_alignment_start(alignment::RIGHT, 20);
+
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::LEFT, 10));
+  EXPECT_EQ(id2, ctxt.has_action(mousebtn::LEFT, 21));
+
+  ctxt.reset();
+
+  EXPECT_EQ(NO_ACTION, ctxt.has_action(mousebtn::LEFT, 1));
+}
+
 TEST(ActionCtxtTest, cmd) {
   action_context ctxt;
 
@@ -0,0 +1,52 @@
+#include "utils/concurrency.hpp"
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+using namespace concurrency_util;
+
+TEST(ParallelFor, empty) {
+  bool called = false;
+  parallel_for(0, [&](size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelFor, visitsEachIndexOnce) {
+  const size_t count = 1000;
+  vector<std::atomic_int> visits(count);
+
+  parallel_for(count, [&](size_t i) { visits[i]++; }, 4);
+
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_EQ(1, visits[i]) << "index " << i;
+  }
+}
+
+TEST(ParallelFor, singleWorkerUsesCallingThread) {
+  std::set<thread::id> ids;
+  parallel_for(10, [&](size_t) { ids.insert(this_thread::get_id()); }, 1);
+
+  EXPECT_EQ(1, ids.size());
+  EXPECT_EQ(1, ids.count(this_thread::get_id()));
+}
+
+TEST(ParallelFor, rethrowsAfterAllCalls) {
+  std::atomic_int calls{0};
+
+  EXPECT_THROW(parallel_for(
+                   100,
+                   [&](size_t i) {
+                     calls++;
+                     if (i == 3) {
+                       throw std::runtime_error("failed");
+                     }
+                   },
+                   4),
+      std::runtime_error);
+
+  EXPECT_EQ(100, calls);
+}
@@ -1,5 +1,7 @@
 #include "utils/file.hpp"
 
+#include <unistd.h>
+
 #include <iomanip>
 #include <iostream>
 
@@ -35,6 +37,7 @@ vector<expand_relative_test_t> expand_relative_test_list = {
     {"../test", "/scratch", "/scratch/../test"},
     {"modules/battery", "/scratch/polybar", "/scratch/polybar/modules/battery"},
     {"/tmp/foo", "/scratch", "/tmp/foo"},
+    {"config.ini", "/scratch/polybar/", "/scratch/polybar/config.ini"},
 };
 
 INSTANTIATE_TEST_SUITE_P(Inst, ExpandRelativeTest, ::testing::ValuesIn(expand_relative_test_list));
@@ -44,3 +47,83 @@ TEST_P(ExpandRelativeTest, correctness) {
   std::tie(path, relative_to, expected) = GetParam();
   EXPECT_EQ(file_util::expand(path, relative_to), expected);
 }
+
+TEST(MappedFile, regularFile) {
+  string path = "/tmp/polybar-test-mapped." + to_string(getpid());
+  file_util::write_contents(path, "foo\nbar\n");
+
+  {
+    mapped_file file(path);
+    EXPECT_EQ("foo\nbar\n", string(file.data(), file.size()));
+  }
+
+  file_util::write_contents(path, "");
+
+  {
+    mapped_file file(path);
+    EXPECT_EQ(0, file.size());
+  }
+
+  unlink(path.c_str());
+}
+
+TEST(MappedFile, missingFile) {
+  EXPECT_THROW(mapped_file("/tmp/polybar-test-does-not-exist"), system_error);
+}
+
+TEST(ProcFile, reread) {
+  string path = "/tmp/polybar-test-proc." + to_string(getpid());
+  file_util::write_contents(path, "42\n");
+
+  proc_file file(path);
+  EXPECT_EQ(-1, file.fd());
+  EXPECT_TRUE(file.read());
+  EXPECT_NE(-1, file.fd());
+  EXPECT_STREQ("42\n", file.data());
+  EXPECT_EQ(3, file.size());
+
+  // Truncated and rewritten in place, read through the same file descriptor
+  file_util::write_contents(path, string(10000, 'x') + "\n");
+  EXPECT_TRUE(file.read());
+  EXPECT_EQ(10001, file.size());
+  EXPECT_EQ('\0', file.data()[file.size()]);
+
+  file_util::write_contents(path, " -1500\n");
+  EXPECT_EQ(-1500, file.read_number());
+  file_util::write_contents(path, "Charging\n");
+  EXPECT_EQ(7, file.read_number(7));
+
+  unlink(path.c_str());
+}
+
+TEST(ProcFile, missingFile) {
+  proc_file file("/tmp/polybar-test-does-not-exist");
+  EXPECT_FALSE(file.read());
+  EXPECT_STREQ("", file.data());
+  EXPECT_EQ(3, file.read_number(3));
+}
+
+TEST(File, parseNumber) {
+  const string str = "cpu0  12 3456\t7 x";
+  const char* pos = str.c_str() + 4;
+  const char* end = str.c_str() + str.size();
+  unsigned long long value;
+
+  EXPECT_TRUE(file_util::parse_number(pos, end, value));
+  EXPECT_EQ(12, value);
+  EXPECT_TRUE(file_util::parse_number(pos, end, value));
+  EXPECT_EQ(3456, value);
+  EXPECT_TRUE(file_util::parse_number(pos, end, value));
+  EXPECT_EQ(7, value);
+  EXPECT_FALSE(file_util::parse_number(pos, end, value));
+  EXPECT_EQ('x', *pos);
+}
+
+TEST(File, contents) {
+  string path = "/tmp/polybar-test-contents." + to_string(getpid());
+  file_util::write_contents(path, "foo\nbar");
+  EXPECT_EQ("foo\nbar", file_util::contents(path));
+  unlink(path.c_str());
+
+  EXPECT_EQ("", file_util::contents(path));
+}
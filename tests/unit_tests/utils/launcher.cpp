@@ -0,0 +1,56 @@
+#include "utils/launcher.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "common/test.hpp"
+#include "utils/file.hpp"
+
+using namespace polybar;
+
+TEST(Launcher, run) {
+  char path[] = "/tmp/polybar-launcher-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+
+  {
+    launcher l;
+    EXPECT_TRUE(l.run("echo foo > " + string{path}));
+    EXPECT_TRUE(l.run(""));
+
+    for (int i = 0; i < 100 && file_util::contents(path).empty(); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ("foo\n", file_util::contents(path));
+  unlink(path);
+}
+
+TEST(Launcher, closesInheritedFds) {
+  char path[] = "/tmp/polybar-launcher-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+
+  int inherited = open("/dev/null", O_RDONLY);
+  ASSERT_NE(-1, inherited);
+
+  {
+    launcher l;
+    EXPECT_TRUE(l.run("if [ -e /proc/self/fd/" + to_string(inherited) + " ]; then echo open; else echo closed; fi > " +
+                      string{path}));
+
+    for (int i = 0; i < 100 && file_util::contents(path).empty(); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  EXPECT_EQ("closed\n", file_util::contents(path));
+  close(inherited);
+  close(fd);
+  unlink(path);
+}
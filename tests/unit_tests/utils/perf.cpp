@@ -0,0 +1,77 @@
+#include "utils/perf.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+using namespace perf_util;
+using std::chrono::microseconds;
+
+TEST(Histogram, empty) {
+  histogram hist;
+
+  EXPECT_EQ(0, hist.count());
+  EXPECT_EQ(0, hist.total());
+  EXPECT_EQ(0, hist.max());
+  EXPECT_EQ(0, hist.percentile(50));
+}
+
+TEST(Histogram, totals) {
+  histogram hist;
+  hist.record(microseconds(10));
+  hist.record(microseconds(30));
+  hist.record(microseconds(2));
+
+  EXPECT_EQ(3, hist.count());
+  EXPECT_EQ(42, hist.total());
+  EXPECT_EQ(30, hist.max());
+}
+
+TEST(Histogram, smallValuesAreExact) {
+  histogram hist;
+  hist.record(microseconds(0));
+  hist.record(microseconds(1));
+  hist.record(microseconds(2));
+  hist.record(microseconds(3));
+
+  EXPECT_EQ(0, hist.percentile(25));
+  EXPECT_EQ(1, hist.percentile(50));
+  EXPECT_EQ(2, hist.percentile(75));
+  EXPECT_EQ(3, hist.percentile(100));
+}
+
+TEST(Histogram, percentiles) {
+  histogram hist;
+  for (int i = 1; i <= 1000; i++) {
+    hist.record(microseconds(i));
+  }
+
+  // Percentiles are bucket upper bounds, which are at most 25% too large
+  for (double p : {50.0, 90.0, 99.0}) {
+    uint64_t exact = static_cast<uint64_t>(p * 10);
+    EXPECT_GE(hist.percentile(p), exact) << p;
+    EXPECT_LE(hist.percentile(p), exact * 5 / 4) << p;
+  }
+
+  EXPECT_EQ(1000, hist.percentile(100));
+}
+
+TEST(Histogram, huge) {
+  histogram hist;
+  hist.record(std::chrono::hours(24 * 365 * 100));
+
+  EXPECT_EQ(1, hist.count());
+  EXPECT_EQ(hist.max(), hist.percentile(50));
+}
+
+TEST(Histogram, json) {
+  histogram hist;
+  hist.record(microseconds(2));
+
+  EXPECT_EQ("{\"count\":1,\"total_us\":2,\"p50_us\":2,\"p90_us\":2,\"p99_us\":2,\"max_us\":2}", to_json(hist));
+}
+
+TEST(PerfUtil, jsonEscape) {
+  EXPECT_EQ("abc", json_escape("abc"));
+  EXPECT_EQ("a\\\"b\\\\c", json_escape("a\"b\\c"));
+  EXPECT_EQ("a\\u000ab", json_escape("a\nb"));
+}
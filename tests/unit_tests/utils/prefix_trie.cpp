@@ -0,0 +1,57 @@
+#include "utils/prefix_trie.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+TEST(PrefixTrie, empty) {
+  prefix_trie<int> trie;
+  size_t length = 0;
+
+  EXPECT_EQ(nullptr, trie.match("", length));
+  EXPECT_EQ(nullptr, trie.match("foo", length));
+}
+
+TEST(PrefixTrie, match) {
+  prefix_trie<int> trie;
+  trie.insert("mpdplay", 1);
+  trie.insert("mpdpause", 2);
+  trie.insert("mpdseek", 3);
+  trie.insert("volup", 4);
+
+  size_t length = 0;
+  const int* value = trie.match("mpdpause", length);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(2, *value);
+  EXPECT_EQ(8, length);
+
+  value = trie.match("mpdseek+5", length);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(3, *value);
+  EXPECT_EQ(7, length);
+
+  EXPECT_EQ(nullptr, trie.match("mpd", length));
+  EXPECT_EQ(nullptr, trie.match("pa_volup", length));
+  EXPECT_EQ(nullptr, trie.match("volu", length));
+}
+
+TEST(PrefixTrie, longestMatch) {
+  prefix_trie<string> trie;
+  trie.insert("a", "short");
+  trie.insert("abc", "long");
+
+  size_t length = 0;
+  EXPECT_EQ("long", *trie.match("abcd", length));
+  EXPECT_EQ(3, length);
+  EXPECT_EQ("short", *trie.match("abd", length));
+  EXPECT_EQ(1, length);
+}
+
+TEST(PrefixTrie, replace) {
+  prefix_trie<int> trie;
+  trie.insert("foo", 1);
+  trie.insert("foo", 2);
+
+  size_t length = 0;
+  EXPECT_EQ(2, *trie.match("foo", length));
+}
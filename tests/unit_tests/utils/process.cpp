@@ -12,8 +12,8 @@
 using namespace polybar;
 using namespace process_util;
 
-TEST(SpawnAsync, is_async) {
-  pid_t pid = spawn_async([] { exec_sh("sleep 0.1"); });
+TEST(SpawnSh, is_async) {
+  pid_t pid = spawn_sh("sleep 0.1");
   int status;
 
   pid_t res = process_util::wait_for_completion_nohang(pid, &status);
@@ -21,10 +21,12 @@ TEST(SpawnAsync, is_async) {
   ASSERT_NE(res, -1);
 
   EXPECT_FALSE(WIFEXITED(status));
+
+  waitpid(pid, &status, 0);
 }
 
-TEST(SpawnAsync, exit_code) {
-  pid_t pid = spawn_async([] { exec_sh("exit 42"); });
+TEST(SpawnSh, exit_code) {
+  pid_t pid = spawn_sh("exit 42");
   int status = 0;
   pid_t res = waitpid(pid, &status, 0);
 
@@ -33,8 +35,8 @@ TEST(SpawnAsync, exit_code) {
   EXPECT_EQ(WEXITSTATUS(status), 42);
 }
 
-TEST(SpawnAsync, env) {
-  pid_t pid = spawn_async([] { exec_sh("exit $EXIT", {{"EXIT", "45"}}); });
+TEST(SpawnSh, env) {
+  pid_t pid = spawn_sh("exit $EXIT", {{"EXIT", "45"}});
   int status = 0;
   pid_t res = waitpid(pid, &status, 0);
 
@@ -42,3 +44,42 @@ TEST(SpawnAsync, env) {
 
   EXPECT_EQ(WEXITSTATUS(status), 45);
 }
+
+TEST(SpawnSh, stdio) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  pid_t pid = spawn_sh("echo out; echo err >&2", {}, {-1, fds[1], fds[1]});
+  close(fds[1]);
+
+  string output;
+  char buf[64];
+  ssize_t bytes;
+  while ((bytes = read(fds[0], buf, sizeof(buf))) > 0) {
+    output.append(buf, bytes);
+  }
+  close(fds[0]);
+
+  waitpid(pid, nullptr, 0);
+  EXPECT_EQ("out\nerr\n", output);
+}
+
+TEST(SpawnSh, process_group) {
+  pid_t pid = spawn_sh("sleep 0.1");
+
+  EXPECT_EQ(pid, getpgid(pid));
+
+  waitpid(pid, nullptr, 0);
+}
+
+TEST(SpawnDetached, reap) {
+  spawn_detached("exit 0");
+
+  size_t running = 1;
+  for (int i = 0; i < 100 && running > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    running = reap_detached();
+  }
+
+  EXPECT_EQ(0, running);
+}
@@ -0,0 +1,86 @@
+#include "utils/ring_buffer.hpp"
+
+#include <thread>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+TEST(RingBuffer, capacity) {
+  EXPECT_EQ(1, mpsc_ring_buffer<int>(1).capacity());
+  EXPECT_EQ(8, mpsc_ring_buffer<int>(5).capacity());
+  EXPECT_EQ(16, mpsc_ring_buffer<int>(16).capacity());
+}
+
+TEST(RingBuffer, fifo) {
+  mpsc_ring_buffer<int> buffer(4);
+  int value = 0;
+
+  EXPECT_FALSE(buffer.try_pop([&](int& v) { value = v; }));
+
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_TRUE(buffer.try_push([&](int& v) { v = i; }));
+  }
+
+  EXPECT_FALSE(buffer.try_push([](int& v) { v = 5; }));
+
+  for (int i = 1; i <= 4; i++) {
+    EXPECT_TRUE(buffer.try_pop([&](int& v) { value = v; }));
+    EXPECT_EQ(i, value);
+  }
+
+  EXPECT_FALSE(buffer.try_pop([&](int& v) { value = v; }));
+}
+
+TEST(RingBuffer, wrapAround) {
+  mpsc_ring_buffer<int> buffer(2);
+  int value = 0;
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(buffer.try_push([&](int& v) { v = i; }));
+    EXPECT_TRUE(buffer.try_pop([&](int& v) { value = v; }));
+    EXPECT_EQ(i, value);
+  }
+}
+
+TEST(RingBuffer, concurrentProducers) {
+  constexpr int producers = 4;
+  constexpr int items = 10000;
+  mpsc_ring_buffer<int> buffer(64);
+
+  vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&buffer, p] {
+      for (int i = 0; i < items; i++) {
+        while (!buffer.try_push([&](int& v) { v = p * items + i; })) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  vector<int> last(producers, -1);
+  int received = 0;
+
+  while (received < producers * items) {
+    int value;
+    if (!buffer.try_pop([&](int& v) { value = v; })) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Items of a single producer must arrive in the order they were pushed
+    int p = value / items;
+    EXPECT_LT(last[p], value % items);
+    last[p] = value % items;
+    received++;
+  }
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (int p = 0; p < producers; p++) {
+    EXPECT_EQ(items - 1, last[p]);
+  }
+}
@@ -0,0 +1,56 @@
+#include "utils/trace.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+static const string EMPTY_TRACE = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}";
+
+TEST(Trace, disabled) {
+  trace_util::start("", 4);
+  trace_util::stop();
+
+  { trace_util::span span("update", "cpu"); }
+  trace_util::instant("broadcast");
+
+  EXPECT_FALSE(trace_util::enabled());
+  EXPECT_EQ(EMPTY_TRACE, trace_util::to_json());
+}
+
+TEST(Trace, events) {
+  trace_util::start("", 4);
+  EXPECT_TRUE(trace_util::enabled());
+
+  { trace_util::span span("update", "cpu"); }
+  trace_util::instant("broadcast");
+  trace_util::stop();
+
+  string json = trace_util::to_json();
+  EXPECT_NE(string::npos, json.find("{\"name\":\"cpu update\",\"cat\":\"polybar\",\"ph\":\"X\",\"ts\":"));
+  EXPECT_NE(string::npos, json.find(",\"dur\":"));
+  EXPECT_NE(string::npos, json.find("{\"name\":\"broadcast\",\"cat\":\"polybar\",\"ph\":\"i\",\"ts\":"));
+  EXPECT_LT(json.find("cpu update"), json.find("broadcast"));
+}
+
+TEST(Trace, keepsMostRecent) {
+  trace_util::start("", 2);
+  trace_util::instant("a");
+  trace_util::instant("b");
+  trace_util::instant("c");
+  trace_util::stop();
+
+  string json = trace_util::to_json();
+  EXPECT_EQ(string::npos, json.find("\"a\""));
+  EXPECT_NE(string::npos, json.find("\"b\""));
+  EXPECT_NE(string::npos, json.find("\"c\""));
+  EXPECT_LT(json.find("\"b\""), json.find("\"c\""));
+}
+
+TEST(Trace, restartDiscards) {
+  trace_util::start("", 2);
+  trace_util::instant("a");
+  trace_util::start("", 2);
+  trace_util::stop();
+
+  EXPECT_EQ(EMPTY_TRACE, trace_util::to_json());
+}
@@ -0,0 +1,42 @@
+#include "utils/wakeup_fd.hpp"
+
+#include <poll.h>
+
+#include <thread>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+static bool readable(const wakeup_fd& wakeup, int timeout = 0) {
+  struct pollfd fd {};
+  fd.fd = wakeup.fd();
+  fd.events = POLLIN;
+  return poll(&fd, 1, timeout) == 1 && (fd.revents & POLLIN);
+}
+
+TEST(WakeupFd, notifyAndDrain) {
+  wakeup_fd wakeup;
+  EXPECT_FALSE(readable(wakeup));
+
+  EXPECT_TRUE(wakeup.notify());
+  EXPECT_TRUE(wakeup.notify());
+  EXPECT_TRUE(readable(wakeup));
+
+  // Stays readable until drained, a single drain resets all notifications
+  EXPECT_TRUE(readable(wakeup));
+  wakeup.drain();
+  EXPECT_FALSE(readable(wakeup));
+
+  // Draining without a notification does not block
+  wakeup.drain();
+  EXPECT_FALSE(readable(wakeup));
+}
+
+TEST(WakeupFd, otherThread) {
+  wakeup_fd wakeup;
+
+  std::thread notifier([&] { wakeup.notify(); });
+  EXPECT_TRUE(readable(wakeup, 5000));
+  notifier.join();
+}